@@ -0,0 +1,162 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/resource.h>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+#include "../LF/LeaderFollower.hpp"
+
+/*
+ * Leader-follower thread pool microbenchmark.
+ *
+ *     ./lf-bench [threads] [round trips] [burst tasks]
+ *
+ * Runs the round-robin pool this project used before and LFP on:
+ *   round trip  add one empty task and wait until it ran, one after the other: the dispatch latency
+ *   burst       add many empty tasks at once and wait for all of them: the throughput
+ * Context switches are the voluntary and involuntary switches of the whole process (getrusage).
+ * A round trip that takes longer than STALL_MS is counted as stalled and the benchmark moves on. The round-robin
+ * pool stalls whenever notify_one wakes a thread that isn't the leader, so its runs take minutes on a single core.
+ */
+
+using namespace std;
+
+const int STALL_MS = 200;
+
+// The previous pool: every thread waits on one condition variable and only the round-robin leader takes a task
+class RoundRobinLFP {
+public:
+    explicit RoundRobinLFP(int num_threads) : stopFlag(false), leader(0) {
+        for (int i = 0; i < num_threads; ++i)
+            threads.emplace_back(&RoundRobinLFP::worker, this, i);
+    }
+
+    ~RoundRobinLFP() {
+        stop();
+    }
+
+    void addTask(function<void()> task) {
+        lock_guard<mutex> lock(queueMutex);
+        taskQueue.push(task);
+        condition.notify_one();
+    }
+
+    void start() {}
+
+    void stop() {
+        {
+            lock_guard<mutex> lock(stopMutex);
+            stopFlag = true;
+        }
+        {
+            lock_guard<mutex> lock(queueMutex);
+            condition.notify_all();
+        }
+        for (thread &t : threads)
+            if (t.joinable())
+                t.join();
+    }
+
+private:
+    void worker(int id) {
+        while (true) {
+            function<void()> task;
+            {
+                unique_lock<mutex> lock(queueMutex);
+                condition.wait(lock, [this]() {
+                    lock_guard<mutex> stopLock(stopMutex);
+                    return stopFlag || !taskQueue.empty();
+                });
+                {
+                    lock_guard<mutex> stopLock(stopMutex);
+                    if (stopFlag && taskQueue.empty()) return;
+                }
+                if (!taskQueue.empty() && leader == id) {
+                    task = taskQueue.front();
+                    taskQueue.pop();
+                } else {
+                    continue;
+                }
+            }
+            {
+                lock_guard<mutex> lock(queueMutex);
+                leader = (size_t)(leader + 1) % threads.size();
+            }
+            task();
+        }
+    }
+
+    vector<thread> threads;
+    queue<function<void()>> taskQueue;
+    mutex queueMutex;
+    mutex stopMutex;
+    condition_variable condition;
+    bool stopFlag;
+    int leader;
+};
+
+// Voluntary plus involuntary context switches of the process so far
+long contextSwitches() {
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_nvcsw + usage.ru_nivcsw;
+}
+
+// Wait until done reaches target or the deadline passes, returns whether it was reached
+bool waitFor(const atomic<size_t> &done, size_t target, chrono::steady_clock::time_point deadline) {
+    while (done.load(memory_order_acquire) < target) {
+        if (chrono::steady_clock::now() > deadline)
+            return false;
+        this_thread::yield();
+    }
+    return true;
+}
+
+template <typename Pool>
+void run(const char *name, int threads, size_t roundTrips, size_t burst) {
+    Pool pool(threads);
+    pool.start();
+    atomic<size_t> done(0);
+
+    // Round trips, one task in flight at a time
+    size_t stalls = 0;
+    long switches = contextSwitches();
+    auto start = chrono::steady_clock::now();
+    for (size_t i = 0; i < roundTrips; i++) {
+        pool.addTask([&done]() { done.fetch_add(1, memory_order_release); });
+        if (!waitFor(done, i + 1, chrono::steady_clock::now() + chrono::milliseconds(STALL_MS)))
+            stalls++; // Only a later addTask may wake the thread that takes it
+    }
+    waitFor(done, roundTrips, chrono::steady_clock::now() + chrono::seconds(10));
+    double tripUs = chrono::duration<double, micro>(chrono::steady_clock::now() - start).count() / (double)roundTrips;
+    long tripSwitches = contextSwitches() - switches;
+
+    // One burst of tasks
+    size_t before = done.load();
+    switches = contextSwitches();
+    start = chrono::steady_clock::now();
+    for (size_t i = 0; i < burst; i++)
+        pool.addTask([&done]() { done.fetch_add(1, memory_order_release); });
+    bool finished = waitFor(done, before + burst, chrono::steady_clock::now() + chrono::seconds(30));
+    double burstMs = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+    long burstSwitches = contextSwitches() - switches;
+
+    printf("%-12s round trip %9.1f us  %8ld switches  %4zu stalled | burst %9.1f ms  %8ld switches%s\n", name,
+           tripUs, tripSwitches, stalls, burstMs, burstSwitches, finished ? "" : "  (incomplete)");
+    fflush(stdout);
+}
+
+int main(int argc, char *argv[]) {
+    int threads = argc > 1 ? atoi(argv[1]) : 4;
+    size_t roundTrips = argc > 2 ? strtoull(argv[2], nullptr, 10) : 100;
+    size_t burst = argc > 3 ? strtoull(argv[3], nullptr, 10) : 10000;
+    printf("%d threads, %zu round trips, %zu burst tasks\n", threads, roundTrips, burst);
+    run<RoundRobinLFP>("round-robin", threads, roundTrips, burst);
+    run<LFP>("LFP", threads, roundTrips, burst);
+    return 0;
+}
@@ -0,0 +1,87 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include <random>
+#include <string>
+#include <vector>
+#include "../Graph/graph.hpp"
+#include "../MST/MST_Strategy.hpp"
+#include "../MST/MST_Factory.hpp"
+
+/*
+ * MST strategy benchmark on generated dense graphs.
+ *
+ *     ./mst-bench [vertices] [density] [random|decreasing] [strategy ...]
+ *
+ * density is the fraction of all vertex pairs that become edges. "random" draws the weights uniformly,
+ * "decreasing" gives (u, v) the weight V - min(u, v), so Prim lowers the key of every neighbour of every vertex
+ * it takes: the decrease-key heavy case the Fibonacci heap is for. Every strategy runs on the same CSR snapshot
+ * and the best of BENCH_RUNS runs is printed with the MST weight, which must agree across strategies.
+ */
+
+const int BENCH_RUNS = 3;
+
+using namespace std;
+
+// Build a graph with about density * V * (V - 1) / 2 edges, connected through a random spanning path
+Graph *denseGraph(size_t V, double density, bool decreasing) {
+    mt19937_64 rng(42);
+    uniform_real_distribution<double> coin(0.0, 1.0);
+    uniform_int_distribution<size_t> weight(1, 1000);
+    vector<Edge> edges;
+    edges.reserve(static_cast<size_t>(density * static_cast<double>(V) * static_cast<double>(V) / 2) + V);
+    for (size_t u = 0; u < V; u++) {
+        for (size_t v = u + 1; v < V; v++) {
+            if (v != u + 1 && coin(rng) >= density)
+                continue; // Keep (u, u + 1) so the graph stays connected
+            edges.emplace_back(u, v, decreasing ? V - u : weight(rng));
+        }
+    }
+    return new Graph(V, edges);
+}
+
+int main(int argc, char *argv[]) {
+    size_t V = argc > 1 ? strtoul(argv[1], nullptr, 10) : 2000;
+    double density = argc > 2 ? atof(argv[2]) : 0.5;
+    bool decreasing = argc > 3 && strcmp(argv[3], "decreasing") == 0;
+    vector<string> strategies;
+    for (int i = 4; i < argc; i++)
+        strategies.push_back(argv[i]);
+    if (strategies.empty())
+        strategies = {"prim", "kruskal", "tarjan"};
+    if (V < 2 || density <= 0 || density > 1) {
+        fprintf(stderr, "usage: %s [vertices >= 2] [density in (0, 1]] [random|decreasing] [strategy ...]\n", argv[0]);
+        return 1;
+    }
+
+    Graph *g = denseGraph(V, density, decreasing);
+    CSRGraph csr = g->snapshot();
+    printf("%zu vertices, %zu edges, %s weights\n", V, g->numEdges(), decreasing ? "decreasing" : "random");
+    for (const string &name : strategies) {
+        MST_Strategy *strat;
+        try {
+            strat = MST_Factory::getInstance()->createMST(name);
+        } catch (const invalid_argument &) {
+            strat = nullptr;
+        }
+        if (strat == nullptr) {
+            printf("%-10s unknown strategy\n", name.c_str());
+            continue;
+        }
+        double best = 0;
+        size_t weight = 0;
+        for (int run = 0; run < BENCH_RUNS; run++) {
+            auto start = chrono::steady_clock::now();
+            Graph *mst = (*strat)(csr);
+            double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+            if (run == 0 || seconds < best)
+                best = seconds;
+            weight = mst->totalWeight();
+            delete mst;
+        }
+        printf("%-10s %9.3f ms   weight %zu\n", name.c_str(), best * 1000, weight);
+    }
+    delete g;
+    return 0;
+}
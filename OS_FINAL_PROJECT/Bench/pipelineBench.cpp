@@ -0,0 +1,114 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "../Pipeline/pipelineActiveObject.hpp"
+
+/*
+ * Pipeline stage configuration microbenchmark.
+ *
+ *     ./pipeline-bench [tasks] [slow stage ms] [slow stage workers]
+ *
+ * Runs tasks through five stages shaped like the server's: four cheap ones and a slow fourth one (the shortest
+ * paths, streamed to the client), simulated by sleeping so it scales on any number of cores. The pipeline runs once
+ * with one worker per stage and once with more workers on the slow stage, with the default queue capacity and with
+ * a capacity of 2 that makes the producer wait. Each run prints its wall time and the stage metrics.
+ * Then three slow stages of one task at a time run one after the other and side by side, between a first and a
+ * joining last stage, for the latency of a single task.
+ */
+
+using namespace std;
+
+struct Run {
+    size_t slowWorkers;
+    size_t capacity;
+};
+
+// Time one run of tasks through the pipeline and print the metrics of its stages
+static void runPipeline(size_t tasks, int slowMs, const Run& run) {
+    mutex doneMtx;
+    condition_variable allDone;
+    size_t done = 0;
+    auto cheap = [](void*) {};
+    vector<PipelineStage> stages = {
+        {cheap, 1, run.capacity},
+        {cheap, 1, run.capacity},
+        {cheap, 1, run.capacity},
+        {[slowMs](void*) { this_thread::sleep_for(chrono::milliseconds(slowMs)); }, run.slowWorkers, run.capacity},
+        {[&](void*) {
+            lock_guard<mutex> lock(doneMtx);
+            if (++done == tasks)
+                allDone.notify_one();
+        }, 1, run.capacity}
+    };
+    Pipeline pipeline(stages);
+    pipeline.start();
+    auto start = chrono::steady_clock::now();
+    static char task;  // The stages don't look at the task
+    for (size_t i = 0; i < tasks; i++)
+        pipeline.addTask(&task);  // Waits while the first queue is full
+    {
+        unique_lock<mutex> lock(doneMtx);
+        allDone.wait(lock, [&]() { return done == tasks; });
+    }
+    double ms = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+    printf("slow stage workers %zu, capacity %zu: %zu tasks in %.1f ms (%.1f tasks/s)\n",
+           run.slowWorkers, run.capacity, tasks, ms, static_cast<double>(tasks) * 1000 / ms);
+    printf("%s\n", pipeline.report().c_str());
+}
+
+// Time tasks one at a time through three slow stages, chained or all after the first stage and joined
+static void runJoin(size_t tasks, int slowMs, bool fanOut) {
+    mutex doneMtx;
+    condition_variable taskDone;
+    bool done = false;
+    auto slow = [slowMs](void*) { this_thread::sleep_for(chrono::milliseconds(slowMs)); };
+    vector<size_t> after1 = {0}, after2 = {fanOut ? 0u : 1u}, after3 = {fanOut ? 0u : 2u};
+    vector<size_t> last = fanOut ? vector<size_t>{1, 2, 3} : vector<size_t>{3};
+    vector<PipelineStage> stages = {
+        {[](void*) {}},
+        {slow, 1, PIPELINE_QUEUE_CAPACITY, after1},
+        {slow, 1, PIPELINE_QUEUE_CAPACITY, after2},
+        {slow, 1, PIPELINE_QUEUE_CAPACITY, after3},
+        {[&](void*) {
+            lock_guard<mutex> lock(doneMtx);
+            done = true;
+            taskDone.notify_one();
+        }, 1, PIPELINE_QUEUE_CAPACITY, last}
+    };
+    Pipeline pipeline(stages);
+    pipeline.start();
+    vector<char> taskIds(tasks);  // One pointer per task, the join tells the tasks apart by it
+    auto start = chrono::steady_clock::now();
+    for (size_t i = 0; i < tasks; i++) {
+        pipeline.addTask(&taskIds[i]);
+        unique_lock<mutex> lock(doneMtx);
+        taskDone.wait(lock, [&]() { return done; });
+        done = false;
+    }
+    double ms = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+    printf("three %d ms stages %s: %.2f ms per task\n", slowMs, fanOut ? "side by side" : "in a chain",
+           ms / static_cast<double>(tasks));
+    printf("%s\n", pipeline.report().c_str());
+}
+
+int main(int argc, char* argv[]) {
+    size_t tasks = argc > 1 ? strtoul(argv[1], nullptr, 10) : 200;
+    int slowMs = argc > 2 ? atoi(argv[2]) : 2;
+    size_t workers = argc > 3 ? strtoul(argv[3], nullptr, 10) : 4;
+    if (tasks == 0 || slowMs < 0 || workers == 0) {
+        fprintf(stderr, "usage: %s [tasks] [slow stage ms] [slow stage workers]\n", argv[0]);
+        return 1;
+    }
+    vector<Run> runs = {{1, PIPELINE_QUEUE_CAPACITY}, {workers, PIPELINE_QUEUE_CAPACITY}, {1, 2}, {workers, 2}};
+    for (const Run& run : runs)
+        runPipeline(tasks, slowMs, run);
+    runJoin(std::max<size_t>(1, tasks / 4), slowMs, false);
+    runJoin(std::max<size_t>(1, tasks / 4), slowMs, true);
+    return 0;
+}
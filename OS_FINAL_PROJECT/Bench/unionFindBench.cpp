@@ -0,0 +1,118 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <chrono>
+#include <random>
+#include <thread>
+#include <vector>
+#include "../DataStruct/data_structures.hpp"
+
+/*
+ * Union-find microbenchmark.
+ *
+ *     ./uf-bench [items] [operations] [threads]
+ *
+ * Runs the same random union and find sequence on the recursive, rank-based union-find this project used before,
+ * on UnionFind and on ConcurrentUnionFind, then splits the unions of ConcurrentUnionFind across threads.
+ * The number of sets left must agree everywhere.
+ */
+
+using namespace std;
+
+// The previous implementation: size_t parents and ranks, recursive find with full path compression
+class RecursiveUnionFind {
+private:
+    vector<size_t> rank, parent;
+
+public:
+    explicit RecursiveUnionFind(size_t n) : rank(n, 0), parent(n) {
+        for (size_t i = 0; i < n; i++)
+            parent[i] = i;
+    }
+
+    size_t find(size_t x) {
+        if (parent[x] == x)
+            return x;
+        return parent[x] = find(parent[x]);
+    }
+
+    bool Union(size_t x, size_t y) {
+        size_t xp = find(x), yp = find(y);
+        if (xp == yp)
+            return false;
+        if (rank[xp] < rank[yp])
+            parent[xp] = yp;
+        else if (rank[xp] > rank[yp])
+            parent[yp] = xp;
+        else {
+            parent[yp] = xp;
+            rank[xp]++;
+        }
+        return true;
+    }
+};
+
+// Time ops on one union-find: every pair is a union if the flag is set and a find on both items otherwise.
+// Returns the number of sets left.
+template <typename UF>
+size_t run(const char *name, size_t n, const vector<pair<uint32_t, uint32_t>> &pairs, const vector<bool> &isUnion) {
+    UF uf(n);
+    size_t sets = n;
+    auto start = chrono::steady_clock::now();
+    for (size_t i = 0; i < pairs.size(); i++) {
+        if (isUnion[i]) {
+            if (uf.Union(pairs[i].first, pairs[i].second))
+                sets--;
+        } else {
+            uf.find(pairs[i].first);
+            uf.find(pairs[i].second);
+        }
+    }
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    printf("%-30s %9.3f ms   %zu sets\n", name, seconds * 1000, sets);
+    return sets;
+}
+
+int main(int argc, char *argv[]) {
+    size_t n = argc > 1 ? strtoul(argv[1], nullptr, 10) : 1000000;
+    size_t ops = argc > 2 ? strtoul(argv[2], nullptr, 10) : 4 * n;
+    size_t numThreads = argc > 3 ? strtoul(argv[3], nullptr, 10) : thread::hardware_concurrency();
+    if (numThreads == 0)
+        numThreads = 1;
+    if (n < 2) {
+        fprintf(stderr, "usage: %s [items >= 2] [operations] [threads]\n", argv[0]);
+        return 1;
+    }
+
+    mt19937_64 rng(7);
+    vector<pair<uint32_t, uint32_t>> pairs(ops);
+    vector<bool> isUnion(ops);
+    for (size_t i = 0; i < ops; i++) {
+        pairs[i] = {static_cast<uint32_t>(rng() % n), static_cast<uint32_t>(rng() % n)};
+        isUnion[i] = rng() % 2 == 0; // Half unions, half pairs of finds
+    }
+    printf("%zu items, %zu operations\n", n, ops);
+    run<RecursiveUnionFind>("recursive, rank (previous)", n, pairs, isUnion);
+    run<UnionFind>("UnionFind", n, pairs, isUnion);
+    run<ConcurrentUnionFind>("ConcurrentUnionFind, 1 thread", n, pairs, isUnion);
+
+    // Only the unions, split across the threads
+    ConcurrentUnionFind shared(n);
+    vector<size_t> merged(numThreads, 0);
+    auto start = chrono::steady_clock::now();
+    vector<thread> threads;
+    for (size_t t = 0; t < numThreads; t++) {
+        threads.emplace_back([&, t]() {
+            for (size_t i = ops * t / numThreads; i < ops * (t + 1) / numThreads; i++)
+                if (isUnion[i] && shared.Union(pairs[i].first, pairs[i].second))
+                    merged[t]++;
+        });
+    }
+    for (auto &th : threads)
+        th.join();
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    size_t sets = n;
+    for (size_t m : merged)
+        sets -= m;
+    printf("ConcurrentUnionFind, %zu threads  %9.3f ms   %zu sets   (unions only)\n", numThreads, seconds * 1000, sets);
+    return 0;
+}
@@ -1,61 +1,125 @@
 #include "data_structures.hpp"
+#include <string>
 
-UnionFind::UnionFind(size_t n): 
-        n(n), 
-        rank(n), 
-        parent(n){ 
+namespace {
+// Check the number of items before anything is allocated for them, ids and sizes are 32-bit
+size_t checkedItems(size_t n, const char *name) {
+    if (n > UINT32_MAX)
+        throw std::invalid_argument(std::string(name) + " supports at most 2^32 - 1 items");
+    return n;
+}
+}
 
+UnionFind::UnionFind(size_t n): 
+        n(checkedItems(n, "UnionFind")), 
+        parent(n), 
+        setSize(n, 1){ 
         create_set(); } 
   
     // Creates n single item sets 
     void UnionFind::create_set() { 
         for (size_t i = 0; i < n; i++) { 
-            parent[i] = i; 
+            parent[i] = static_cast<uint32_t>(i); 
+            setSize[i] = 1; 
         } 
     } 
   
     // Finds set of given item x 
     size_t UnionFind::find(size_t x) { 
-       // If i is the parent of itself 
-    if (parent[x] == x) { 
-        // Then i is the representative  
+        while (parent[x] != x) { 
+            // Path halving: skip the parent, the path gets half as long on every find 
+            parent[x] = parent[parent[x]]; 
+            x = parent[x]; 
+        } 
         return x; 
     } 
-    else {  
-        // Recursively find the representative. 
-        size_t res = find(parent[x]); 
   
-        // We cache the result by moving i’s node directly under the representative of this set 
-        parent[x] = res; 
-        
-        // And then we return the result 
-        return res; 
-     } 
+    // Finds set of given item x without compressing the path
+    size_t UnionFind::root(size_t x) const { 
+        while (parent[x] != x) 
+            x = parent[x]; 
+        return x; 
     } 
   
-    // Do union of two sets by rank represented by x and y. 
-    void UnionFind::Union(size_t x, size_t y) { 
+    // Do union of the sets of x and y by size
+    bool UnionFind::Union(size_t x, size_t y) { 
         // Find current sets of x and y 
         size_t xp = find(x); 
         size_t yp = find(y); 
 
         // If they are already in same set 
         if (xp == yp) 
-            return; 
+            return false; 
   
-        // Put smaller ranked item under bigger ranked item if ranks are different 
-        if (rank[xp] < rank[yp]) { 
-            parent[xp] = yp; 
-        } 
-        else if (rank[xp] > rank[yp]) { 
-            parent[yp] = xp; 
-        } 
-        //If ranks are same, then increment rank. 
-        else { 
-            parent[yp] = xp; 
-            rank[xp] = rank[xp] + 1; 
-        } 
+        // Put the smaller set under the larger one, the trees stay O(log n) deep 
+        if (setSize[xp] < setSize[yp]) 
+            std::swap(xp, yp); 
+        parent[yp] = static_cast<uint32_t>(xp); 
+        setSize[xp] += setSize[yp]; 
+        return true; 
+    }
+
+    // Get the number of items 
+    size_t UnionFind::size() const { 
+        return n; 
     } 
 
 
-  
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+
+
+ConcurrentUnionFind::ConcurrentUnionFind(size_t n) :
+        n(checkedItems(n, "ConcurrentUnionFind")),
+        parent(new std::atomic<uint32_t>[n]){
+    for (size_t i = 0; i < n; i++)
+        parent[i].store(static_cast<uint32_t>(i), std::memory_order_relaxed);
+}
+
+// Finds the current root of the set of x
+size_t ConcurrentUnionFind::find(size_t x) {
+    while (true) {
+        uint32_t p = parent[x].load(std::memory_order_acquire);
+        if (p == x)
+            return x;
+        uint32_t grandparent = parent[p].load(std::memory_order_acquire);
+        if (grandparent == p)
+            return p;
+        // Path halving, x only ever moves up to an ancestor, so losing the race to another thread is harmless
+        parent[x].compare_exchange_weak(p, grandparent, std::memory_order_release, std::memory_order_relaxed);
+        x = grandparent;
+    }
+}
+
+// Check if x and y are in the same set
+bool ConcurrentUnionFind::sameSet(size_t x, size_t y) {
+    while (true) {
+        size_t xr = find(x), yr = find(y);
+        if (xr == yr)
+            return true;
+        // Different roots only count if xr is still a root, otherwise it was linked meanwhile and we look again
+        if (parent[xr].load(std::memory_order_acquire) == xr)
+            return false;
+    }
+}
+
+// Do union of the sets of x and y
+bool ConcurrentUnionFind::Union(size_t x, size_t y) {
+    while (true) {
+        size_t xr = find(x), yr = find(y);
+        if (xr == yr)
+            return false;
+        if (xr > yr)
+            std::swap(xr, yr); // Link the smaller id under the larger one, links always point up in id order
+        uint32_t expected = static_cast<uint32_t>(xr);
+        if (parent[xr].compare_exchange_strong(expected, static_cast<uint32_t>(yr), std::memory_order_acq_rel))
+            return true;
+        // xr was linked by another thread first, retry from the new roots
+    }
+}
+
+// Get the number of items
+size_t ConcurrentUnionFind::size() const {
+    return n;
+}
@@ -1,150 +1,550 @@
+#ifndef DATA_STRUCTURES_HPP
+#define DATA_STRUCTURES_HPP
 #include <vector>
 #include <stdexcept>
-#include <algorithm> // For std::find
-#include <map>
+#include <algorithm> // For std::min
 #include <vector>
 #include <stddef.h>
+#include <stdint.h>
+#include <atomic>
+#include <memory>
 
   
+// Disjoint sets of items 0..n-1 with 32-bit parents and set sizes, 8 bytes per item.
+// find is iterative with path halving, so long chains can't overflow the stack, and unions are by size.
 class UnionFind { 
 
 private:
     size_t n; 
-    std::vector<size_t> rank, parent;
+    std::vector<uint32_t> parent, setSize; // setSize is only meaningful for roots
 
   
 public: 
     // Constructor to create and 
-    // initialize sets of n items 
+    // initialize sets of n items, at most 2^32 - 1 of them
     UnionFind(size_t n);
   
     // Creates n single item sets 
     void create_set();
   
-    // Finds set of given item x 
+    // Finds set of given item x, every other node on the way is pointed at its grandparent
     size_t find(size_t x);
+
+    // Finds set of given item x without compressing the path, safe from several threads while nobody unions
+    size_t root(size_t x) const;
   
-    // Do union of two sets by rank represented 
-    // by x and y. 
-    void Union(size_t x, size_t y);
+    // Do union of the sets of x and y, the smaller set goes under the larger one.
+    // Returns false if they were already in the same set.
+    bool Union(size_t x, size_t y);
+
+    // Get the number of items
+    size_t size() const;
 }; 
+
+
+// UnionFind that several threads can use at once without a lock.
+// find halves paths with compare-and-swap, a failed swap only means another thread already shortened the path.
+// Union links the root with the smaller id under the other one with a CAS that succeeds only while it is still a
+// root, and retries from the new roots otherwise, so sets only ever merge and ids give a fixed link order.
+class ConcurrentUnionFind {
+
+private:
+    size_t n;
+    std::unique_ptr<std::atomic<uint32_t>[]> parent;
+
+public:
+    // Create n single item sets, at most 2^32 - 1 of them
+    explicit ConcurrentUnionFind(size_t n);
+
+    // Finds the current root of the set of x
+    size_t find(size_t x);
+
+    // Check if x and y are in the same set. Exact when no union runs at the same time.
+    bool sameSet(size_t x, size_t y);
+
+    // Do union of the sets of x and y, returns false if they were already in the same set
+    bool Union(size_t x, size_t y);
+
+    // Get the number of items
+    size_t size() const;
+};
   
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////
 
-///////////// Binary Heap struct /////////////
+///////////// Indexed d-ary Heap /////////////
+
+// Min-heap of items 0..n-1 ordered by (key, item), with the heap slot of every item kept in a flat array.
+// Lookup of an item is O(1), decreaseKey needs no search, and after the constructor no operation allocates.
+// Arity is the number of children per node: 4 or 8 make the tree shallower and keep the children of a node
+// in one or two cache lines, which pays off when decreaseKey dominates (Prim on sparse graphs).
+template <typename Key, size_t Arity = 4>
+class IndexedHeap {
+    static_assert(Arity == 2 || Arity == 4 || Arity == 8, "IndexedHeap arity must be 2, 4 or 8");
 
-template <typename T, typename Comparator = std::less<T>>
-class BinaryHeap {
 public:
-    BinaryHeap() = default; // Default constructor
+    static constexpr size_t NOT_IN_HEAP = static_cast<size_t>(-1); // Slot of an item that is not in the heap
+
+    // Create an empty heap for items 0..n-1
+    explicit IndexedHeap(size_t n) : heap(), slot(n, NOT_IN_HEAP) {
+        heap.reserve(n); // Every item fits without reallocating
+    }
+
+    // Check if the heap is empty
+    bool empty() const {
+        return heap.empty();
+    }
+
+    // Get the number of items in the heap
+    size_t size() const {
+        return heap.size();
+    }
+
+    // Check if an item is in the heap
+    bool contains(size_t item) const {
+        return slot[item] != NOT_IN_HEAP;
+    }
 
-    // Insert a new value into the heap
-    void push(const T& val) {
-        heap.push_back(val); // Add value to the end of the heap
-        indexMap[val] = heap.size() - 1; // Store index of the new value
-        heapifyUp(heap.size() - 1); // Restore heap property
+    // Get the current key of an item in the heap
+    const Key &key(size_t item) const {
+        if (!contains(item)) {
+            throw std::invalid_argument("Cannot find the item in heap");
+        }
+        return heap[slot[item]].key;
     }
 
-    // Remove the top value from the heap
-    void pop() {
+    // Get the item with the smallest key
+    size_t top() const {
         if (heap.empty()) {
             throw std::out_of_range("Out of range: Heap is empty");
         }
-        indexMap.erase(heap.front()); // Remove the top element from the index map
-        std::swap(heap.front(), heap.back()); // Swap top and last elements
-        heap.pop_back(); // Remove last element (previously top)
+        return heap.front().item;
+    }
+
+    // Insert an item that is not in the heap yet
+    void push(size_t item, const Key &k) {
+        if (contains(item)) {
+            throw std::invalid_argument("Item is already in heap");
+        }
+        heap.push_back(Entry{k, item});
+        slot[item] = heap.size() - 1;
+        siftUp(heap.size() - 1);
+    }
+
+    // Remove the item with the smallest key and return it
+    size_t pop() {
+        size_t item = top();
+        slot[item] = NOT_IN_HEAP;
+        Entry last = heap.back();
+        heap.pop_back();
         if (!heap.empty()) {
-            indexMap[heap.front()] = 0; // Update index of the new top
-            heapifyDown(0); // Restore heap property
+            heap.front() = last; // Move the last entry to the root and sink it
+            slot[last.item] = 0;
+            siftDown(0);
         }
+        return item;
     }
 
-    // Get the top value of the heap
-    const T& top() const {
-        if (heap.empty()) {
-            throw std::out_of_range("Out of range: Heap is empty");
+    // Lower the key of an item in the heap
+    void decreaseKey(size_t item, const Key &k) {
+        if (!contains(item)) {
+            throw std::invalid_argument("Cannot find the item in heap");
+        }
+        size_t index = slot[item];
+        if (k > heap[index].key) {
+            throw std::invalid_argument("New key is greater than current key");
+        }
+        heap[index].key = k;
+        siftUp(index);
+    }
+
+    // Insert the item, or lower its key if k is smaller. Returns true if the heap changed.
+    bool pushOrDecrease(size_t item, const Key &k) {
+        if (!contains(item)) {
+            push(item, k);
+            return true;
+        }
+        if (!(k < heap[slot[item]].key)) {
+            return false; // The current key is already as small
+        }
+        decreaseKey(item, k);
+        return true;
+    }
+
+private:
+    // Key and item side by side, so comparisons don't chase another array
+    struct Entry {
+        Key key;
+        size_t item;
+        bool operator<(const Entry &other) const {
+            return key < other.key || (!(other.key < key) && item < other.item); // Ties go to the smaller item
         }
-        return heap.front(); // Return top element
+    };
+
+    std::vector<Entry> heap;  // Heap-ordered entries
+    std::vector<size_t> slot; // Heap index of every item, NOT_IN_HEAP when absent
+
+    // Move the entry at index up until its parent is smaller, shifting parents down instead of swapping
+    void siftUp(size_t index) {
+        Entry moving = heap[index];
+        while (index > 0) {
+            size_t parent = (index - 1) / Arity;
+            if (!(moving < heap[parent])) {
+                break; // Heap property is satisfied
+            }
+            heap[index] = heap[parent];
+            slot[heap[index].item] = index;
+            index = parent;
+        }
+        heap[index] = moving;
+        slot[moving.item] = index;
+    }
+
+    // Move the entry at index down until all of its children are larger
+    void siftDown(size_t index) {
+        Entry moving = heap[index];
+        const size_t n = heap.size();
+        while (true) {
+            size_t first = index * Arity + 1; // First child
+            if (first >= n) {
+                break; // Leaf
+            }
+            size_t last = std::min(first + Arity, n);
+            size_t smallest = first;
+            for (size_t child = first + 1; child < last; child++) {
+                if (heap[child] < heap[smallest]) {
+                    smallest = child;
+                }
+            }
+            if (!(heap[smallest] < moving)) {
+                break; // Heap property is satisfied
+            }
+            heap[index] = heap[smallest];
+            slot[heap[index].item] = index;
+            index = smallest;
+        }
+        heap[index] = moving;
+        slot[moving.item] = index;
+    }
+};
+
+///////////// Indexed Fibonacci Heap /////////////
+
+// Fibonacci min-heap of items 0..n-1 ordered by (key, item), as used by Fredman and Tarjan for Prim.
+// decreaseKey is O(1) amortized (cut the node to the root list, cascade cuts up marked parents) and pop is
+// O(log n) amortized. The nodes live in flat arrays indexed by item, so no operation allocates.
+template <typename Key>
+class FibonacciHeap {
+public:
+    static constexpr size_t NONE = static_cast<size_t>(-1); // No node
+
+    // Create an empty heap for items 0..n-1
+    explicit FibonacciHeap(size_t n) :
+        key(n), parent(n, NONE), child(n, NONE), left(n), right(n), degree(n, 0), mark(n, false), inHeap(n, false),
+        byDegree(2 * (sizeof(size_t) * 8) + 2, NONE), roots(), minNode(NONE), count(0) {
+        roots.reserve(n); // Scratch for pop, filled without reallocating
     }
 
     // Check if the heap is empty
     bool empty() const {
-        return heap.empty();
+        return count == 0;
     }
 
-    // Get the size of the heap
+    // Get the number of items in the heap
     size_t size() const {
-        return heap.size();
+        return count;
+    }
+
+    // Check if an item is in the heap
+    bool contains(size_t item) const {
+        return inHeap[item];
+    }
+
+    // Get the item with the smallest key
+    size_t top() const {
+        if (count == 0) {
+            throw std::out_of_range("Out of range: Heap is empty");
+        }
+        return minNode;
+    }
+
+    // Insert an item that is not in the heap yet, O(1)
+    void push(size_t item, const Key &k) {
+        if (inHeap[item]) {
+            throw std::invalid_argument("Item is already in heap");
+        }
+        key[item] = k;
+        parent[item] = child[item] = NONE;
+        degree[item] = 0;
+        mark[item] = false;
+        inHeap[item] = true;
+        left[item] = right[item] = item;
+        addRoot(item);
+        count++;
     }
 
-    // Get the index of a value in the heap
-    size_t getIndex(const T& val) const {
-        auto it = indexMap.find(val);
-        if (it == indexMap.end()) {
-            throw std::invalid_argument("Cannot find the value in heap");
+    // Remove the item with the smallest key and return it, O(log n) amortized
+    size_t pop() {
+        size_t z = top();
+        // Move the children of z to the root list
+        size_t c = child[z];
+        if (c != NONE) {
+            size_t start = c;
+            do {
+                size_t next = right[c];
+                parent[c] = NONE;
+                mark[c] = false;
+                left[c] = right[c] = c;
+                splice(c, z); // Next to z in the root list
+                c = next;
+            } while (c != start);
+            child[z] = NONE;
         }
-        return it->second; // Return index of the value
+        // Unlink z and rebuild the root list with at most one tree per degree
+        size_t next = right[z];
+        unlink(z);
+        inHeap[z] = false;
+        count--;
+        minNode = next == z ? NONE : next;
+        if (minNode != NONE) {
+            consolidate();
+        }
+        return z;
     }
 
-    // Decrease the key of a value at a given index
-    void decreaseKey(size_t index, const T& newKey) {
-        if (index >= heap.size()) {
-            throw std::out_of_range("Index out of range: index bigger than heap");
+    // Lower the key of an item in the heap, O(1) amortized
+    void decreaseKey(size_t item, const Key &k) {
+        if (!inHeap[item]) {
+            throw std::invalid_argument("Cannot find the item in heap");
         }
-        if (comp(heap[index], newKey)) {
+        if (k > key[item]) {
             throw std::invalid_argument("New key is greater than current key");
         }
-        heap[index] = newKey; // Update the key value
-        indexMap[newKey] = index; // Update index map
-        heapifyUp(index); // Restore heap property
+        key[item] = k;
+        size_t p = parent[item];
+        if (p != NONE && less(item, p)) {
+            cut(item, p);
+            cascadingCut(p);
+        }
+        if (less(item, minNode)) {
+            minNode = item;
+        }
+    }
+
+    // Insert the item, or lower its key if k is smaller. Returns true if the heap changed.
+    bool pushOrDecrease(size_t item, const Key &k) {
+        if (!inHeap[item]) {
+            push(item, k);
+            return true;
+        }
+        if (!(k < key[item])) {
+            return false; // The current key is already as small
+        }
+        decreaseKey(item, k);
+        return true;
     }
 
 private:
-    std::vector<T> heap; // Vector to store heap elements
-    Comparator comp; // Comparator for heap property
-    std::map<T, size_t> indexMap; // Map to track indices of values
+    std::vector<Key> key;
+    std::vector<size_t> parent, child;  // Tree links
+    std::vector<size_t> left, right;    // Circular sibling list (the root list for roots)
+    std::vector<size_t> degree;         // Number of children
+    std::vector<bool> mark;             // Lost a child since it became a child itself
+    std::vector<bool> inHeap;
+    std::vector<size_t> byDegree;       // Consolidation table, one root per degree
+    std::vector<size_t> roots;          // Scratch copy of the root list
+    size_t minNode;
+    size_t count;
 
-    // Restore heap property upwards
-    void heapifyUp(size_t index) {
-        while (index > 0) {
-            size_t indx_parent = (index - 1) / 2; // Calculate parent index
-            if (!comp(heap[index], heap[indx_parent])) {
-                break; // If heap property is satisfied, break
+    // Order by key, ties go to the smaller item
+    bool less(size_t a, size_t b) const {
+        return key[a] < key[b] || (!(key[b] < key[a]) && a < b);
+    }
+
+    // Insert the single node x into the sibling list after y
+    void splice(size_t x, size_t y) {
+        left[x] = y;
+        right[x] = right[y];
+        left[right[y]] = x;
+        right[y] = x;
+    }
+
+    // Remove x from its sibling list
+    void unlink(size_t x) {
+        right[left[x]] = right[x];
+        left[right[x]] = left[x];
+        left[x] = right[x] = x;
+    }
+
+    // Add the single node x to the root list
+    void addRoot(size_t x) {
+        if (minNode == NONE) {
+            minNode = x;
+            return;
+        }
+        splice(x, minNode);
+        if (less(x, minNode)) {
+            minNode = x;
+        }
+    }
+
+    // Make root y a child of root x
+    void link(size_t y, size_t x) {
+        unlink(y);
+        parent[y] = x;
+        mark[y] = false;
+        if (child[x] == NONE) {
+            child[x] = y;
+        } else {
+            splice(y, child[x]);
+        }
+        degree[x]++;
+    }
+
+    // Merge roots of equal degree until every degree appears once
+    void consolidate() {
+        roots.clear();
+        size_t r = minNode;
+        do {
+            roots.push_back(r);
+            r = right[r];
+        } while (r != minNode);
+        for (size_t x : roots) {
+            size_t d = degree[x];
+            while (byDegree[d] != NONE) {
+                size_t y = byDegree[d];
+                if (less(y, x)) {
+                    std::swap(x, y);
+                }
+                link(y, x); // The larger root goes under the smaller one
+                byDegree[d] = NONE;
+                d++;
+            }
+            byDegree[d] = x;
+        }
+        // Find the new minimum and clear the table for the next pop
+        minNode = NONE;
+        for (size_t &slot : byDegree) {
+            if (slot != NONE && (minNode == NONE || less(slot, minNode))) {
+                minNode = slot;
             }
-            // Swap current index with parent
-            std::swap(heap[index], heap[indx_parent]);
-            indexMap[heap[index]] = index; // Update index map
-            indexMap[heap[indx_parent]] = indx_parent; // Update parent index
-            index = indx_parent; // Move up to parent index
+            slot = NONE;
         }
     }
 
-    // Restore heap property downwards
-    void heapifyDown(size_t index) {
-        size_t leftChild, rightChild, smallest;
-        while (true) {
-            leftChild = 2 * index + 1; // Left child index
-            rightChild = 2 * index + 2; // Right child index
-            smallest = index; // Assume current index is smallest
+    // Move x from the children of p to the root list
+    void cut(size_t x, size_t p) {
+        if (right[x] == x) {
+            child[p] = NONE;
+        } else {
+            if (child[p] == x) {
+                child[p] = right[x];
+            }
+            unlink(x);
+        }
+        degree[p]--;
+        parent[x] = NONE;
+        mark[x] = false;
+        splice(x, minNode);
+    }
 
-            // Check if left child exists and is smaller
-            if (leftChild < heap.size() && comp(heap[leftChild], heap[smallest])) {
-                smallest = leftChild;
+    // Cut marked ancestors, so no tree loses more than one child per level before being restructured
+    void cascadingCut(size_t y) {
+        size_t p = parent[y];
+        while (p != NONE) {
+            if (!mark[y]) {
+                mark[y] = true;
+                return;
             }
-            // Check if right child exists and is smaller
-            if (rightChild < heap.size() && comp(heap[rightChild], heap[smallest])) {
-                smallest = rightChild;
+            cut(y, p);
+            y = p;
+            p = parent[y];
+        }
+    }
+};
+
+///////////// Bounded MPMC Ring /////////////
+
+// Bounded lock-free queue for any number of producers and consumers (Vyukov's ring). Every cell carries a
+// sequence number telling whose turn it is: a producer claims the cell at enqueuePos when its sequence equals the
+// position, a consumer the cell at dequeuePos when its sequence is one past it. One CAS per operation, no locks,
+// and values are handed over in FIFO order. Capacity is a power of two fixed at construction.
+template <typename T>
+class MPMCRing {
+public:
+    explicit MPMCRing(size_t capacity) : cells(), mask(capacity - 1), enqueuePos(0), dequeuePos(0) {
+        if (capacity < 2 || (capacity & (capacity - 1)) != 0) {
+            throw std::invalid_argument("Invalid argument: ring capacity must be a power of two");
+        }
+        cells.reset(new Cell[capacity]);
+        for (size_t i = 0; i < capacity; i++) {
+            cells[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    MPMCRing(const MPMCRing &) = delete;
+    MPMCRing &operator=(const MPMCRing &) = delete;
+
+    // Add value at the back, false (value untouched) when the ring is full
+    bool tryPush(T &value) {
+        size_t pos = enqueuePos.load(std::memory_order_relaxed);
+        while (true) {
+            Cell &cell = cells[pos & mask];
+            size_t seq = cell.sequence.load(std::memory_order_acquire);
+            if (seq == pos) {
+                if (enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    cell.value = std::move(value);
+                    cell.sequence.store(pos + 1, std::memory_order_release); // Hand the cell to the consumers
+                    return true;
+                }
+            } else if (seq < pos) {
+                return false; // The cell still holds a value from a lap ago
+            } else {
+                pos = enqueuePos.load(std::memory_order_relaxed); // Another producer took it
             }
-            if (smallest == index) {
-                break; // If no swaps needed, break
+        }
+    }
+
+    // Take the value at the front, false when the ring is empty
+    bool tryPop(T &value) {
+        size_t pos = dequeuePos.load(std::memory_order_relaxed);
+        while (true) {
+            Cell &cell = cells[pos & mask];
+            size_t seq = cell.sequence.load(std::memory_order_acquire);
+            if (seq == pos + 1) {
+                if (dequeuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    value = std::move(cell.value);
+                    cell.sequence.store(pos + mask + 1, std::memory_order_release); // Free for the next lap
+                    return true;
+                }
+            } else if (seq < pos + 1) {
+                return false; // Not written yet
+            } else {
+                pos = dequeuePos.load(std::memory_order_relaxed); // Another consumer took it
             }
-            // Swap current index with smallest
-            std::swap(heap[index], heap[smallest]);
-            indexMap[heap[index]] = index; // Update index map
-            indexMap[heap[smallest]] = smallest; // Update smallest index
-            index = smallest; // Move down to smallest index
         }
     }
+
+    // Check if the ring looks empty, exact only while nobody pushes or pops
+    bool empty() const {
+        return enqueuePos.load(std::memory_order_acquire) == dequeuePos.load(std::memory_order_acquire);
+    }
+
+    // Get the number of values the ring holds
+    size_t capacity() const {
+        return mask + 1;
+    }
+
+private:
+    struct Cell {
+        std::atomic<size_t> sequence;
+        T value;
+    };
+
+    std::unique_ptr<Cell[]> cells;
+    size_t mask;
+    alignas(64) std::atomic<size_t> enqueuePos; // Producers and consumers on separate cache lines
+    alignas(64) std::atomic<size_t> dequeuePos;
 };
 
+#endif // DATA_STRUCTURES_HPP
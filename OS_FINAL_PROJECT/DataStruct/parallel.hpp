@@ -0,0 +1,64 @@
+#ifndef PARALLEL_HPP
+#define PARALLEL_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <algorithm>
+#include <cstddef>
+#include "workStealingPool.hpp"
+
+///////////// Parallel for /////////////
+
+// Get the number of worker threads to use for data-parallel loops
+inline size_t parallelism() {
+    size_t hw = std::thread::hardware_concurrency();
+    return hw == 0 ? 1 : hw;
+}
+
+// Run body(i) for every i in [0, count) across the hardware threads.
+// Iterations are handed out dynamically through an atomic counter, the call returns when all of them are done.
+// The helpers run on the shared work-stealing pool and the calling thread claims iterations as well, so a loop
+// always makes progress even when every worker is busy, including a loop nested in a pool task. A helper that
+// only starts once every iteration is claimed returns without touching body.
+template <typename Body>
+void parallelFor(size_t count, Body body) {
+    size_t numThreads = std::min(parallelism(), count);
+    if (numThreads <= 1) {
+        for (size_t i = 0; i < count; i++) {
+            body(i); // Not worth a thread, run inline
+        }
+        return;
+    }
+    struct Loop {
+        std::atomic<size_t> next{0};
+        std::atomic<size_t> done{0};
+        std::mutex mtx;
+        std::condition_variable finished;
+    };
+    auto loop = std::make_shared<Loop>(); // Shared with helpers that may start after the call returned
+    Body *work = &body;                   // Only used for a claimed iteration, the call is still waiting then
+    auto claim = [loop, work, count]() {
+        size_t ran = 0;
+        for (size_t i = loop->next.fetch_add(1); i < count; i = loop->next.fetch_add(1)) {
+            (*work)(i);
+            ran++;
+        }
+        if (ran != 0 && loop->done.fetch_add(ran) + ran == count) {
+            std::lock_guard<std::mutex> lock(loop->mtx);
+            loop->finished.notify_all();
+        }
+    };
+    WorkStealingPool &pool = WorkStealingPool::global();
+    for (size_t t = 1; t < numThreads; t++) {
+        pool.submit(claim);
+    }
+    claim(); // The calling thread takes part as well
+    std::unique_lock<std::mutex> lock(loop->mtx);
+    loop->finished.wait(lock, [&loop, count]() { return loop->done.load() == count; });
+}
+
+#endif // PARALLEL_HPP
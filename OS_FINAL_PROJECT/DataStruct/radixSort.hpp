@@ -0,0 +1,120 @@
+#ifndef RADIX_SORT_HPP
+#define RADIX_SORT_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <algorithm>
+#include "parallel.hpp"
+
+///////////// Parallel LSD radix sort /////////////
+
+const unsigned RADIX_BITS = 8;                   // One byte per pass
+const size_t RADIX_BUCKETS = size_t(1) << RADIX_BITS;
+const size_t RADIX_MIN_CHUNK = 1 << 15;          // Below this many items per chunk a thread costs more than it sorts
+const uint64_t COUNTING_SORT_MAX_RANGE = 1 << 16; // Key ranges below this are sorted in one counting pass
+
+// Split count items into about a few chunks per thread, at least RADIX_MIN_CHUNK items each
+inline size_t radixChunks(size_t count) {
+    return std::max<size_t>(1, std::min(parallelism() * 4, count / RADIX_MIN_CHUNK));
+}
+
+// One stable counting pass: scatter from[0..count) to `to` by digit(item) in [0, buckets).
+// The digits of every chunk are counted in parallel, the counts become per (digit, chunk) offsets and the chunks
+// are scattered in parallel, chunk order keeps items with the same digit in their input order.
+// Returns false without touching `to` when every item has the same digit, the pass would only copy.
+template <typename T, typename Digit>
+bool countingPass(const T *from, T *to, size_t count, size_t numChunks, size_t buckets, Digit digit,
+                  std::vector<size_t> &offsets) {
+    auto chunkBegin = [&](size_t c) { return count * c / numChunks; };
+    offsets.assign(numChunks * buckets, 0); // offsets[c * buckets + d]
+    parallelFor(numChunks, [&](size_t c) {
+        size_t *counts = &offsets[c * buckets];
+        for (size_t i = chunkBegin(c); i < chunkBegin(c + 1); i++) {
+            counts[digit(from[i])]++;
+        }
+    });
+    // Exclusive prefix sum in (digit, chunk) order
+    size_t sum = 0, largest = 0;
+    for (size_t d = 0; d < buckets; d++) {
+        size_t digitTotal = 0;
+        for (size_t c = 0; c < numChunks; c++) {
+            size_t n = offsets[c * buckets + d];
+            offsets[c * buckets + d] = sum;
+            sum += n;
+            digitTotal += n;
+        }
+        largest = std::max(largest, digitTotal);
+    }
+    if (largest == count) {
+        return false;
+    }
+    parallelFor(numChunks, [&](size_t c) {
+        size_t *next = &offsets[c * buckets];
+        for (size_t i = chunkBegin(c); i < chunkBegin(c + 1); i++) {
+            to[next[digit(from[i])]++] = from[i];
+        }
+    });
+    return true;
+}
+
+// Stable sort of items[0..count) by the unsigned integer key(item), so the result is the same on every run.
+// Keys are taken relative to the smallest one. When that range is below COUNTING_SORT_MAX_RANGE and below
+// than count, a single counting pass sorts everything; otherwise an LSD radix sort runs one pass per byte of the
+// range, least significant first. Both are O(count) per pass.
+template <typename T, typename Key>
+void radixSort(T *items, size_t count, Key key) {
+    if (count < 2) {
+        return;
+    }
+    const size_t numChunks = radixChunks(count);
+    auto chunkBegin = [&](size_t c) { return count * c / numChunks; };
+
+    // Smallest and largest key, bound the range to sort
+    std::vector<uint64_t> chunkMin(numChunks), chunkMax(numChunks);
+    parallelFor(numChunks, [&](size_t c) {
+        uint64_t lo = UINT64_MAX, hi = 0;
+        for (size_t i = chunkBegin(c); i < chunkBegin(c + 1); i++) {
+            uint64_t k = key(items[i]);
+            lo = std::min(lo, k);
+            hi = std::max(hi, k);
+        }
+        chunkMin[c] = lo;
+        chunkMax[c] = hi;
+    });
+    const uint64_t minKey = *std::min_element(chunkMin.begin(), chunkMin.end());
+    const uint64_t range = *std::max_element(chunkMax.begin(), chunkMax.end()) - minKey;
+    if (range == 0) {
+        return; // All keys are equal, already sorted
+    }
+
+    std::vector<T> scratch(count);
+    std::vector<size_t> offsets;
+    if (range < COUNTING_SORT_MAX_RANGE && range < count) {
+        auto digit = [&](const T &item) { return static_cast<size_t>(static_cast<uint64_t>(key(item)) - minKey); };
+        if (countingPass(items, scratch.data(), count, numChunks, static_cast<size_t>(range) + 1, digit, offsets)) {
+            std::copy(scratch.begin(), scratch.end(), items);
+        }
+        return;
+    }
+    T *from = items, *to = scratch.data();
+    for (unsigned shift = 0; shift < 64 && (range >> shift) != 0; shift += RADIX_BITS) {
+        auto digit = [&](const T &item) {
+            return static_cast<size_t>(((static_cast<uint64_t>(key(item)) - minKey) >> shift) & (RADIX_BUCKETS - 1));
+        };
+        if (countingPass(from, to, count, numChunks, RADIX_BUCKETS, digit, offsets)) {
+            std::swap(from, to);
+        }
+    }
+    if (from != items) {
+        std::copy(from, from + count, items); // An odd number of passes ended in the scratch buffer
+    }
+}
+
+// Stable sort of a whole vector by the unsigned integer key(item)
+template <typename T, typename Key>
+void radixSort(std::vector<T> &items, Key key) {
+    radixSort(items.data(), items.size(), key);
+}
+
+#endif // RADIX_SORT_HPP
@@ -0,0 +1,116 @@
+#include "workStealingPool.hpp"
+#include "parallel.hpp"
+
+namespace {
+// Pool and worker index of the calling thread, null outside every pool
+thread_local WorkStealingPool *currentPool = nullptr;
+thread_local size_t currentWorker = 0;
+}
+
+// Start numWorkers worker threads
+WorkStealingPool::WorkStealingPool(size_t numWorkers) : workers(), sharedMtx(), shared(), queued(0), sleeping(0),
+    stopping(false), sleepMtx(), wake(), threads(){
+    numWorkers = std::max<size_t>(1, numWorkers);
+    for (size_t i = 0; i < numWorkers; i++)
+        workers.emplace_back(new Worker());
+    for (size_t i = 0; i < numWorkers; i++)
+        threads.emplace_back(&WorkStealingPool::run, this, i);
+}
+
+// Run the tasks still queued, then join the workers
+WorkStealingPool::~WorkStealingPool(){
+    stopping = true;
+    {
+        std::lock_guard<std::mutex> lock(sleepMtx);
+        wake.notify_all();
+    }
+    for (auto &thread : threads)
+        thread.join();
+}
+
+// Queue a task to run on one of the workers
+void WorkStealingPool::submit(std::function<void()> task){
+    if (currentPool == this){
+        Worker &own = *workers[currentWorker];
+        std::lock_guard<std::mutex> lock(own.mtx);
+        own.tasks.push_back(std::move(task));
+    }
+    else{
+        std::lock_guard<std::mutex> lock(sharedMtx);
+        shared.push_back(std::move(task));
+    }
+    // Both are sequentially consistent, as in run: either a worker going to sleep sees the task or this sees it
+    queued.fetch_add(1);
+    if (sleeping.load() != 0){
+        std::lock_guard<std::mutex> lock(sleepMtx);
+        wake.notify_one();
+    }
+}
+
+// Get the number of workers
+size_t WorkStealingPool::size() const{
+    return workers.size();
+}
+
+// Get the pool shared by the whole process
+WorkStealingPool &WorkStealingPool::global(){
+    // Never destroyed: a task still running at exit would otherwise hold up the exit, or outlive what it uses
+    static WorkStealingPool *pool = new WorkStealingPool(parallelism());
+    return *pool;
+}
+
+// Take a task for worker self
+bool WorkStealingPool::take(size_t self, std::function<void()> &task){
+    {
+        Worker &own = *workers[self];
+        std::lock_guard<std::mutex> lock(own.mtx);
+        if (!own.tasks.empty()){
+            task = std::move(own.tasks.back()); // Newest first
+            own.tasks.pop_back();
+            queued.fetch_sub(1);
+            return true;
+        }
+    }
+    {
+        std::lock_guard<std::mutex> lock(sharedMtx);
+        if (!shared.empty()){
+            task = std::move(shared.front());
+            shared.pop_front();
+            queued.fetch_sub(1);
+            return true;
+        }
+    }
+    for (size_t k = 1; k < workers.size(); k++){
+        Worker &victim = *workers[(self + k) % workers.size()];
+        std::lock_guard<std::mutex> lock(victim.mtx);
+        if (!victim.tasks.empty()){
+            task = std::move(victim.tasks.front()); // Oldest, the one the victim would get to last
+            victim.tasks.pop_front();
+            queued.fetch_sub(1);
+            return true;
+        }
+    }
+    return false;
+}
+
+// Worker loop
+void WorkStealingPool::run(size_t self){
+    currentPool = this;
+    currentWorker = self;
+    std::function<void()> task;
+    while (true){
+        if (take(self, task)){
+            task();
+            task = nullptr; // Release what the task captured before sleeping
+            continue;
+        }
+        if (stopping && queued.load() == 0)
+            return;
+        std::unique_lock<std::mutex> lock(sleepMtx);
+        sleeping.fetch_add(1);
+        // Check again, a task submitted before sleeping was raised did not notify
+        if (queued.load() == 0 && !stopping)
+            wake.wait(lock);
+        sleeping.fetch_sub(1);
+    }
+}
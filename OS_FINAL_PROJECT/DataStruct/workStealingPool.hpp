@@ -0,0 +1,62 @@
+#ifndef WORK_STEALING_POOL_HPP
+#define WORK_STEALING_POOL_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+///////////// Work-stealing thread pool /////////////
+
+// Thread pool with one task deque per worker.
+// A task submitted by a worker goes to the back of that worker's own deque and the worker takes its newest task
+// first, while its data is still in cache. A worker whose deque is empty takes the oldest task submitted from
+// outside the pool, then steals the oldest task of another worker. Idle workers sleep until a task is submitted.
+class WorkStealingPool {
+public:
+    // Start numWorkers worker threads, at least one
+    explicit WorkStealingPool(size_t numWorkers);
+
+    // Run the tasks still queued, then join the workers
+    ~WorkStealingPool();
+
+    WorkStealingPool(const WorkStealingPool &) = delete;
+    WorkStealingPool &operator=(const WorkStealingPool &) = delete;
+
+    // Queue a task to run on one of the workers
+    void submit(std::function<void()> task);
+
+    // Get the number of workers
+    size_t size() const;
+
+    // Get the pool shared by the whole process, one worker per hardware thread. Created on first use.
+    static WorkStealingPool &global();
+
+private:
+    struct alignas(64) Worker {
+        std::mutex mtx;
+        std::deque<std::function<void()>> tasks;
+    };
+
+    std::vector<std::unique_ptr<Worker>> workers;
+    std::mutex sharedMtx;
+    std::deque<std::function<void()>> shared;  // Tasks submitted from outside the pool
+    std::atomic<size_t> queued;                // Tasks submitted and not taken yet
+    std::atomic<size_t> sleeping;              // Workers asleep or about to be, submit only notifies then
+    std::atomic<bool> stopping;
+    std::mutex sleepMtx;
+    std::condition_variable wake;
+    std::vector<std::thread> threads;
+
+    // Take a task for worker self: its own newest, the oldest submitted from outside, or the oldest of another worker
+    bool take(size_t self, std::function<void()> &task);
+    // Worker loop
+    void run(size_t self);
+};
+
+#endif // WORK_STEALING_POOL_HPP
@@ -0,0 +1,129 @@
+#include "csr.hpp"
+#include "graph.hpp"
+#include <stdexcept>
+
+// Empty snapshot
+CSRGraph::CSRGraph() : n(0), offsets(1, 0), neighbors(), weights() {}
+
+// Build a snapshot of the adjacency of g
+CSRGraph::CSRGraph(const Graph &g) : n(0), offsets(), neighbors(), weights()
+{
+    // Vertex ids are 0..n-1, they index the rows
+    if (!g.denseIds())
+        throw std::logic_error("CSRGraph: vertex ids of the graph are not 0..n-1");
+    n = g.numVertices();
+
+    // First pass: count the degree of every vertex
+    offsets.assign(n + 1, 0);
+    for (auto it = g.begin(); it != g.end(); it++){
+        offsets[static_cast<size_t>(it->first) + 1] = it->second.getAdj().size();
+    }
+    for (size_t i = 0; i < n; i++){
+        offsets[i + 1] += offsets[i]; // Prefix sum into row offsets
+    }
+
+    // Second pass: copy the neighbours and weights into their rows
+    neighbors.resize(offsets[n]);
+    weights.resize(offsets[n]);
+    for (auto it = g.begin(); it != g.end(); it++){
+        size_t pos = offsets[static_cast<size_t>(it->first)];
+        for (const auto &adj : it->second.getAdj()){
+            neighbors[pos] = static_cast<uint32_t>(adj.first);
+            weights[pos] = adj.second;
+            pos++;
+        }
+    }
+}
+
+// Get the number of vertices in the snapshot
+size_t CSRGraph::numVertices() const { return n; }
+
+// Check if this is a snapshot of g, row by row in the order the constructor copies them
+bool CSRGraph::matches(const Graph &g) const
+{
+    if (!g.denseIds() || g.numVertices() != n)
+        return false;
+    size_t total = 0;
+    for (auto it = g.begin(); it != g.end(); it++){
+        size_t u = static_cast<size_t>(it->first), pos = offsets[u];
+        if (it->second.getAdj().size() != offsets[u + 1] - pos)
+            return false;
+        for (const auto &adj : it->second.getAdj()){
+            if (neighbors[pos] != adj.first || weights[pos] != adj.second)
+                return false;
+            pos++;
+        }
+        total += it->second.getAdj().size();
+    }
+    return total == neighbors.size();
+}
+
+// Get the approximate heap footprint of the snapshot
+size_t CSRGraph::bytes() const
+{
+    return offsets.capacity() * sizeof(size_t) + neighbors.capacity() * sizeof(uint32_t) + weights.capacity() * sizeof(size_t);
+}
+
+// Get the number of undirected edges in the snapshot
+size_t CSRGraph::numEdges() const { return neighbors.size() / 2; }
+
+// Get the number of neighbours of u
+size_t CSRGraph::degree(size_t u) const { return offsets[u + 1] - offsets[u]; }
+
+// Range of the neighbours of u
+const uint32_t *CSRGraph::neighborsBegin(size_t u) const { return neighbors.data() + offsets[u]; }
+const uint32_t *CSRGraph::neighborsEnd(size_t u) const { return neighbors.data() + offsets[u + 1]; }
+const size_t *CSRGraph::weightsBegin(size_t u) const { return weights.data() + offsets[u]; }
+
+// Raw arrays
+const std::vector<size_t> &CSRGraph::getOffsets() const { return offsets; }
+const std::vector<uint32_t> &CSRGraph::getNeighbors() const { return neighbors; }
+const std::vector<size_t> &CSRGraph::getWeights() const { return weights; }
+
+// Check if the snapshot is connected using BFS, O(V + E)
+bool CSRGraph::isConnected() const
+{
+    if (n == 0)
+        return true;
+    std::vector<bool> visited(n, false); // Track visited vertices
+    std::vector<uint32_t> queue;         // Flat BFS queue, every vertex is pushed at most once
+    queue.reserve(n);
+    queue.push_back(0); // Start from the first vertex
+    visited[0] = true;
+    for (size_t head = 0; head < queue.size(); head++){
+        size_t curr = queue[head];
+        for (const uint32_t *v = neighborsBegin(curr); v != neighborsEnd(curr); v++){
+            if (!visited[*v]){
+                visited[*v] = true; // Mark as visited
+                queue.push_back(*v);
+            }
+        }
+    }
+    return queue.size() == n; // Check if all vertices are visited
+}
+
+// Get total weight of the undirected edges
+size_t CSRGraph::totalWeight() const
+{
+    size_t total = 0;
+    for (size_t u = 0; u < n; u++){
+        for (size_t i = offsets[u]; i < offsets[u + 1]; i++){
+            if (u < neighbors[i])
+                total += weights[i]; // Count every undirected edge once
+        }
+    }
+    return total;
+}
+
+// Get the adjacency matrix of the snapshot
+std::vector<std::vector<size_t>> CSRGraph::adjacencyMatrix() const
+{
+    std::vector<std::vector<size_t>> mat(n, std::vector<size_t>(n, INF)); // Initialize with INF
+    for (size_t u = 0; u < n; u++){
+        for (size_t i = offsets[u]; i < offsets[u + 1]; i++){
+            mat[u][neighbors[i]] = weights[i];
+        }
+        mat[u][u] = 0; // Distance to itself
+    }
+    return mat;
+}
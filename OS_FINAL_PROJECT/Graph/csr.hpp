@@ -0,0 +1,60 @@
+#pragma once
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+class Graph;
+
+/**
+ * @brief Immutable compressed sparse row (CSR) snapshot of a Graph.
+ * The neighbours of vertex u are stored contiguously in neighbors[offsets[u] .. offsets[u + 1])
+ * and the weight of the edge to neighbors[i] is weights[i]. Every undirected edge appears twice.
+ */
+class CSRGraph
+{
+private:
+    size_t n;                        // Number of vertices
+    std::vector<size_t> offsets;     // Start of each vertex row, offsets[n] == neighbors.size()
+    std::vector<uint32_t> neighbors; // Neighbour ids, row by row
+    std::vector<size_t> weights;     // Weight of the edge to the matching neighbour
+
+public:
+    // Empty snapshot
+    CSRGraph();
+
+    // Build a snapshot of the adjacency of g
+    explicit CSRGraph(const Graph &g);
+
+    // Get the number of vertices in the snapshot
+    size_t numVertices() const;
+    // Get the number of undirected edges in the snapshot
+    size_t numEdges() const;
+    // Get the number of neighbours of u
+    size_t degree(size_t u) const;
+
+    // Range of the neighbours of u
+    const uint32_t *neighborsBegin(size_t u) const;
+    const uint32_t *neighborsEnd(size_t u) const;
+    // Weights matching neighborsBegin(u) .. neighborsEnd(u)
+    const size_t *weightsBegin(size_t u) const;
+
+    // Raw arrays, for algorithms that scan the whole snapshot
+    const std::vector<size_t> &getOffsets() const;
+    const std::vector<uint32_t> &getNeighbors() const;
+    const std::vector<size_t> &getWeights() const;
+
+    // Check if the snapshot is connected using BFS, O(V + E)
+    bool isConnected() const;
+
+    // Check if this is a snapshot of g's current edges, O(V + E) without building one
+    bool matches(const Graph &g) const;
+
+    // Get the approximate heap footprint of the snapshot in bytes
+    size_t bytes() const;
+
+    // Get total weight of the undirected edges
+    size_t totalWeight() const;
+
+    // Get the adjacency matrix of the snapshot (INF where there is no edge, 0 on the diagonal)
+    std::vector<std::vector<size_t>> adjacencyMatrix() const;
+};
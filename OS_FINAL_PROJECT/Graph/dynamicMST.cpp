@@ -0,0 +1,211 @@
+#include "dynamicMST.hpp"
+#include "graph.hpp"
+#include <algorithm>
+
+// Track forest, a minimum spanning forest of the graph
+DynamicMST::DynamicMST(const Graph &forest) :
+    adj(),
+    isValid(true),
+    mark(),
+    via(),
+    queue(),
+    epoch(0){
+    size_t n = 0;
+    for (const auto &pair : forest)
+        n = std::max(n, static_cast<size_t>(pair.first) + 1); // Ids are 0..n-1
+    adj.resize(n);
+    mark.assign(n, 0);
+    via.resize(n);
+    queue.reserve(n);
+    for (const auto &pair : forest){
+        size_t u = static_cast<size_t>(pair.first);
+        for (const auto &neighbour : pair.second.getAdj())
+            if (u < neighbour.first) // Every tree edge is in both adjacency maps, take it once
+                addTreeEdge(u, neighbour.first, neighbour.second);
+    }
+}
+
+// Check if the forest still matches the graph
+bool DynamicMST::valid() const{
+    return isValid;
+}
+
+// Get the weight of tree edge (u, v)
+bool DynamicMST::treeWeight(size_t u, size_t v, size_t &w) const{
+    for (const auto &e : adj[u]){
+        if (e.first == v){
+            w = e.second;
+            return true;
+        }
+    }
+    return false;
+}
+
+void DynamicMST::addTreeEdge(size_t u, size_t v, size_t w){
+    adj[u].emplace_back(static_cast<uint32_t>(v), w);
+    adj[v].emplace_back(static_cast<uint32_t>(u), w);
+}
+
+void DynamicMST::removeTreeEdge(size_t u, size_t v){
+    auto drop = [](std::vector<std::pair<uint32_t, size_t>> &list, size_t other){
+        for (size_t i = 0; i < list.size(); i++){
+            if (list[i].first == other){
+                list[i] = list.back(); // Order of the neighbours doesn't matter
+                list.pop_back();
+                return;
+            }
+        }
+    };
+    drop(adj[u], v);
+    drop(adj[v], u);
+}
+
+// Find the heaviest edge on the tree path from u to v
+bool DynamicMST::heaviestOnPath(size_t u, size_t v, size_t &a, size_t &b, size_t &w){
+    // Breadth first search from u until v is reached, via[] remembers the way back
+    epoch++;
+    queue.clear();
+    queue.push_back(static_cast<uint32_t>(u));
+    mark[u] = epoch;
+    for (size_t head = 0; head < queue.size() && mark[v] != epoch; head++){
+        uint32_t x = queue[head];
+        for (const auto &e : adj[x]){
+            if (mark[e.first] != epoch){
+                mark[e.first] = epoch;
+                via[e.first] = x;
+                queue.push_back(e.first);
+            }
+        }
+    }
+    if (mark[v] != epoch)
+        return false; // Different trees
+    // Walk back from v to u keeping the heaviest edge
+    bool found = false;
+    for (size_t x = v; x != u; x = via[x]){
+        size_t weight = 0;
+        treeWeight(x, via[x], weight);
+        if (!found || weight > w){
+            a = via[x];
+            b = x;
+            w = weight;
+            found = true;
+        }
+    }
+    return found;
+}
+
+// Connect the two halves left by removing the tree edge (u, v) with their lightest graph edge
+void DynamicMST::reconnect(size_t u, size_t v, const Graph &graph){
+    // Grow both halves one vertex at a time, the half that runs out first is the smaller one and the only one
+    // whose graph edges have to be scanned
+    const uint64_t sideU = ++epoch, sideV = ++epoch;
+    std::vector<uint32_t> other; // Search of the v half, queue holds the u half
+    queue.clear();
+    queue.push_back(static_cast<uint32_t>(u));
+    other.push_back(static_cast<uint32_t>(v));
+    mark[u] = sideU;
+    mark[v] = sideV;
+    size_t headU = 0, headV = 0;
+    auto step = [&](std::vector<uint32_t> &q, size_t &head, uint64_t side){
+        uint32_t x = q[head++];
+        for (const auto &e : adj[x]){
+            if (mark[e.first] != side){
+                mark[e.first] = side;
+                q.push_back(e.first);
+            }
+        }
+    };
+    while (headU < queue.size() && headV < other.size()){
+        step(queue, headU, sideU);
+        if (headU < queue.size())
+            step(other, headV, sideV);
+    }
+    const std::vector<uint32_t> &half = headU == queue.size() ? queue : other;
+    const uint64_t side = headU == queue.size() ? sideU : sideV;
+
+    // Lightest graph edge leaving the smaller half, it can only lead into the other half
+    bool found = false;
+    size_t bestA = 0, bestB = 0, bestW = 0;
+    for (uint32_t x : half){
+        for (const auto &e : graph.getVertex(static_cast<int>(x)).getAdj()){
+            if (mark[e.first] != side && (!found || e.second < bestW)){
+                bestA = x;
+                bestB = e.first;
+                bestW = e.second;
+                found = true;
+            }
+        }
+    }
+    if (found)
+        addTreeEdge(bestA, bestB, bestW); // Otherwise the graph itself fell apart, the forest has one more tree
+}
+
+// Update the forest after the edge (u, v) was added or had its weight changed to w
+void DynamicMST::insertEdge(size_t u, size_t v, size_t w, const Graph &graph){
+    if (!isValid)
+        return;
+    if (u >= adj.size() || v >= adj.size()){
+        isValid = false; // A vertex the forest doesn't know, the owner recomputes
+        return;
+    }
+    if (u == v)
+        return; // A self loop is never part of a spanning forest
+    size_t current = 0;
+    if (treeWeight(u, v, current)){
+        if (w <= current){
+            // A lighter tree edge keeps the forest minimal, only its weight changes
+            removeTreeEdge(u, v);
+            addTreeEdge(u, v, w);
+            return;
+        }
+        // A heavier tree edge may lose to another edge across the same cut, the edge itself competes as well
+        removeTreeEdge(u, v);
+        reconnect(u, v, graph);
+        return;
+    }
+    size_t a = 0, b = 0, heaviest = 0;
+    if (!heaviestOnPath(u, v, a, b, heaviest)){
+        addTreeEdge(u, v, w); // Joins two trees
+        return;
+    }
+    if (w < heaviest){
+        // Cycle rule: the new edge replaces the heaviest edge of the cycle it closes
+        removeTreeEdge(a, b);
+        addTreeEdge(u, v, w);
+    }
+}
+
+// Update the forest after the edge (u, v) was removed
+void DynamicMST::removeEdge(size_t u, size_t v, const Graph &graph){
+    if (!isValid)
+        return;
+    if (u >= adj.size() || v >= adj.size()){
+        isValid = false;
+        return;
+    }
+    size_t w = 0;
+    if (!treeWeight(u, v, w))
+        return; // Not a tree edge, the forest is still minimal
+    removeTreeEdge(u, v);
+    reconnect(u, v, graph);
+}
+
+// Get the forest as a new graph over the same vertices
+Graph *DynamicMST::tree() const{
+    Graph *g = new Graph(adj.size());
+    for (size_t u = 0; u < adj.size(); u++)
+        for (const auto &e : adj[u])
+            if (u < e.first)
+                g->addEdge(Edge(u, e.first, e.second));
+    return g;
+}
+
+// Get the total weight of the forest
+size_t DynamicMST::totalWeight() const{
+    size_t total = 0;
+    for (size_t u = 0; u < adj.size(); u++)
+        for (const auto &e : adj[u])
+            if (u < e.first)
+                total += e.second;
+    return total;
+}
@@ -0,0 +1,60 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+class Graph;
+
+/*
+ * Minimum spanning forest of a graph, kept up to date across single edge updates instead of being recomputed.
+ *
+ *   insert (u, v, w)    the heaviest edge on the tree path u..v is replaced by (u, v) if w is lighter, or (u, v)
+ *                       joins two trees when there is no path. O(size of the tree).
+ *   delete tree edge    the tree splits in two, the lightest graph edge between the halves reconnects them.
+ *                       Only the smaller half and its graph edges are scanned.
+ *   delete other edge   nothing to do.
+ *
+ * A weight change of an existing edge is handled as the matching insert or delete and reinsert.
+ * Vertex ids must stay below the n the forest was built for, an update outside it invalidates the forest and the
+ * owner has to recompute it from scratch.
+ */
+class DynamicMST {
+public:
+    // Track forest, a minimum spanning forest of the graph computed by one of the MST strategies
+    explicit DynamicMST(const Graph &forest);
+
+    // Check if the forest still matches the graph
+    bool valid() const;
+
+    // Update the forest after the edge (u, v) was added to graph with weight w, or had its weight changed to w
+    void insertEdge(size_t u, size_t v, size_t w, const Graph &graph);
+
+    // Update the forest after the edge (u, v) was removed from graph
+    void removeEdge(size_t u, size_t v, const Graph &graph);
+
+    // Get the forest as a new graph over the same vertices
+    Graph *tree() const;
+
+    // Get the total weight of the forest
+    size_t totalWeight() const;
+
+private:
+    std::vector<std::vector<std::pair<uint32_t, size_t>>> adj; // Tree neighbours and edge weights of every vertex
+    bool isValid;
+
+    // Scratch for the traversals, marks are compared against an epoch so they never need clearing
+    std::vector<uint64_t> mark;
+    std::vector<uint32_t> via;      // Vertex a traversal reached each vertex from
+    std::vector<uint32_t> queue;
+    uint64_t epoch;
+
+    // Get the weight of tree edge (u, v), or false if it is not in the tree
+    bool treeWeight(size_t u, size_t v, size_t &w) const;
+    void addTreeEdge(size_t u, size_t v, size_t w);
+    void removeTreeEdge(size_t u, size_t v);
+    // Find the heaviest edge (a, b) on the tree path from u to v, false if they are in different trees
+    bool heaviestOnPath(size_t u, size_t v, size_t &a, size_t &b, size_t &w);
+    // After the tree edge (u, v) was removed: connect the two halves with their lightest graph edge, if any
+    void reconnect(size_t u, size_t v, const Graph &graph);
+};
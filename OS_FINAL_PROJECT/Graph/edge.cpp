@@ -1,30 +1,34 @@
 #include "edge.hpp"
 #include "vertex.hpp"
+#include <stdexcept>
+#include <string>
+
+namespace {
+// Vertex ids are stored in 32 bits, refuse a larger one instead of cutting it to another vertex
+uint32_t checkedId(size_t id){
+    if (id > UINT32_MAX)
+        throw std::out_of_range("Edge: vertex id " + std::to_string(id) + " does not fit in 32 bits");
+    return static_cast<uint32_t>(id);
+}
+}
 
-
-// Constructor to create a weighted edge
-Edge::Edge(Vertex s, Vertex e, size_t w) : start(s), end(e), weight(w) {}
-// Copy constructor to create an edge
-Edge::Edge(const Edge &other) : start(other.start), end(other.end), weight(other.weight) {}
+// Constructor to create a weighted edge between two vertex ids
+Edge::Edge(size_t s, size_t e, size_t w) : start(checkedId(s)), end(checkedId(e)), weight(w) {}
+// Constructor to create a weighted edge between two vertices
+Edge::Edge(const Vertex &s, const Vertex &e, size_t w) : Edge(s.getId(), e.getId(), w) {}
 // Getters and setters for edge properties
-Vertex &Edge::getStart() { return start; } // Return a reference to the start vertex
-const Vertex &Edge::getStart() const { return start; } // Return a const reference to the start vertex
-Vertex &Edge::getEnd() { return end; } // Return a reference to the end vertex
-const Vertex &Edge::getEnd() const { return end; } // Return a const reference to the end vertex
+size_t Edge::getStart() const { return start; } // Return the id of the start vertex
+size_t Edge::getEnd() const { return end; } // Return the id of the end vertex
 size_t &Edge::getWeight() { return weight; } // Return a reference to the edge's weight
 size_t Edge::getWeight() const { return weight; } // Return the edge's weight as a value
 
-// Get the vertex at the other end of the edge
-Vertex &Edge::getOther(Vertex v) {
+// Get the id of the vertex at the other end of the edge
+size_t Edge::getOther(size_t v) const {
     return start == v ? end : start; // Return the vertex opposite to the given vertex
 }
 
-const Vertex &Edge::getOther(Vertex v) const {
-    return start == v ? end : start; // Return the opposite vertex as a const reference
-}
-
 // Check if the edge contains a specific vertex
-bool Edge::contains(Vertex &target) const {
+bool Edge::contains(size_t target) const {
     return start == target || end == target; // Return true if the edge contains the target vertex
 }
 
@@ -33,14 +37,6 @@ bool Edge::operator==(const Edge &other) const {
     return start == other.start && end == other.end; // Check if two edges are equal by comparing vertices
 }
 
-// Assignment operator
-Edge &Edge::operator=(const Edge &other) {
-    start = other.start; // Assign the start vertex
-    end = other.end;     // Assign the end vertex
-    weight = other.weight; // Assign the weight
-    return *this; // Return the current edge
-}
-
 // Less-than operator for comparing edges based on weight
 bool Edge::operator<(const Edge &other) const {
     return weight < other.weight; // Return true if this edge's weight is less than the other's
@@ -48,6 +44,6 @@ bool Edge::operator<(const Edge &other) const {
 
 // Overload the output stream operator for Edge
 std::ostream& operator<<(std::ostream &os, const Edge &e) {
-    os << e.start << " -- " << e.end << " (" << e.weight << ")"; // Output the edge in a readable format
+    os << "Vertex " << e.start << " -- Vertex " << e.end << " (" << e.weight << ")"; // Output the edge in a readable format
     return os; // Return the output stream
-}
\ No newline at end of file
+}
@@ -1,51 +1,52 @@
 #pragma once
 #include <functional>
+#include <cstdint>
+#include <type_traits>
 #include "vertex.hpp"
 #include <iostream>
 
 
+/**
+ * @brief Lightweight undirected edge: two 32-bit vertex ids and a weight.
+ * The edge does not own any container, so it is trivially copyable and
+ * vectors of edges can be sorted and copied as flat memory.
+ */
 class Edge
 {
 private:
-    // The start and end vertices of the edge
-    Vertex start;
-    Vertex end;
-    // Whether the edge is weighted and the weight of the edge
+    // The ids of the start and end vertices of the edge
+    uint32_t start;
+    uint32_t end;
+    // The weight of the edge
     size_t weight;
 
 public:
-    // Constructor to create a weighted edge
-    Edge(Vertex s, Vertex e, size_t w = 1);
+    // Constructor to create a weighted edge between two vertex ids
+    Edge(size_t s, size_t e, size_t w = 1);
+
+    // Constructor to create a weighted edge between two vertices
+    Edge(const Vertex &s, const Vertex &e, size_t w = 1);
 
     // Default constructor
     Edge() = default;
 
-    // Copy constructor to create an edge
-    Edge(const Edge &other);
-
     // Getters and setters for edge properties
-    Vertex &getStart();
-    const Vertex &getStart() const;
-    Vertex &getEnd();
-    const Vertex &getEnd() const;
+    size_t getStart() const;
+    size_t getEnd() const;
 
     size_t &getWeight();
     size_t getWeight() const;
 
-    // Get the vertex at the other end of the edge
-    Vertex &getOther(Vertex v);
-    const Vertex &getOther(Vertex v) const;
+    // Get the id of the vertex at the other end of the edge
+    size_t getOther(size_t v) const;
 
-    // Check if the edge contains a specific vertex
-    bool contains(Vertex &target) const;
+    // Check if the edge contains a specific vertex id
+    bool contains(size_t target) const;
 
 
     // Equality operator
     bool operator==(const Edge &other) const;
 
-    //Assignment operator
-    Edge &operator=(const Edge &other);
-
     //Less than operator
     bool operator<(const Edge &other) const;
 
@@ -53,6 +54,9 @@ public:
 
     };
 
+static_assert(std::is_trivially_copyable<Edge>::value, "Edge must stay trivially copyable");
+static_assert(sizeof(Edge) <= 16, "Edge must fit in 16 bytes");
+
 
 
 // Hash function for the Edge class, used in unordered_set
@@ -63,13 +67,11 @@ namespace std
     {
         std::size_t operator()(const Edge &e) const
         {
-            std::size_t h1 = std::hash<Vertex>{}(e.getStart());
-            std::size_t h2 =std::hash<Vertex>{}(e.getEnd());
-            return h1 ^ (h2 << 1);
+            // Both ids fit in 32 bits, pack them into one word
+            return std::hash<uint64_t>{}((static_cast<uint64_t>(e.getStart()) << 32) | e.getEnd());
         }
     };
 }
 
 
 
-
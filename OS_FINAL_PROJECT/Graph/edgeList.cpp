@@ -0,0 +1,238 @@
+#include "edgeList.hpp"
+#include "../DataStruct/parallel.hpp"
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <algorithm>
+#include <climits>
+#include <cstring>
+#include <cerrno>
+
+namespace {
+
+const size_t MIN_CHUNK = 1 << 20; // Below 1 MiB per chunk the threads cost more than they save
+
+// Read-only mapping of a whole file, unmapped on destruction
+struct MappedFile {
+    const char *data = nullptr;
+    size_t size = 0;
+
+    ~MappedFile() {
+        if (data != nullptr)
+            munmap(const_cast<char *>(data), size);
+    }
+
+    // Map the file at path, false and error on failure
+    bool open(const std::string &path, std::string &error) {
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            error = "Cannot open " + path + ": " + strerror(errno);
+            return false;
+        }
+        struct stat st;
+        if (fstat(fd, &st) < 0 || !S_ISREG(st.st_mode) || st.st_size == 0) {
+            error = path + " is not a non-empty regular file";
+            close(fd);
+            return false;
+        }
+        size_t length = static_cast<size_t>(st.st_size);
+        void *p = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+        close(fd); // The mapping keeps the file alive
+        if (p == MAP_FAILED) {
+            error = "Cannot map " + path + ": " + strerror(errno);
+            return false;
+        }
+        madvise(p, length, MADV_SEQUENTIAL); // Every page is read once, front to back
+        data = static_cast<const char *>(p);
+        size = length;
+        return true;
+    }
+};
+
+// Read a little-endian 32-bit value from an unaligned buffer
+inline uint32_t loadLE32(const char *p) {
+    const unsigned char *b = reinterpret_cast<const unsigned char *>(p);
+    return static_cast<uint32_t>(b[0]) | (static_cast<uint32_t>(b[1]) << 8) | (static_cast<uint32_t>(b[2]) << 16) | (static_cast<uint32_t>(b[3]) << 24);
+}
+
+// Split count items into about one chunk per MIN_CHUNK bytes, a few chunks per thread so fast threads pick up more
+size_t chunkCount(size_t bytes) {
+    return std::max<size_t>(1, std::min(parallelism() * 4, bytes / MIN_CHUNK));
+}
+
+// Skip spaces, tabs and carriage returns
+inline void skipBlanks(const char *&p, const char *end) {
+    while (p < end && (*p == ' ' || *p == '\t' || *p == '\r'))
+        p++;
+}
+
+// Parse an unsigned number at p, false if there is none or it does not fit in 32 bits
+inline bool parseNumber(const char *&p, const char *end, size_t &value) {
+    const char *start = p;
+    value = 0;
+    while (p < end && *p >= '0' && *p <= '9') {
+        value = value * 10 + static_cast<size_t>(*p - '0');
+        if (value > UINT32_MAX)
+            return false;
+        p++;
+    }
+    return p != start;
+}
+
+// Parse the numbers of one line into values and move p past the line.
+// Returns how many numbers were read, 0 for a blank or comment line and -1 for anything else.
+int parseLine(const char *&p, const char *end, size_t values[3]) {
+    int count = 0;
+    skipBlanks(p, end);
+    if (p < end && *p == '#') {
+        const char *eol = static_cast<const char *>(memchr(p, '\n', static_cast<size_t>(end - p)));
+        p = eol == nullptr ? end : eol + 1; // Skip the comment
+        return 0;
+    }
+    while (p < end && *p != '\n') {
+        if (count == 3 || !parseNumber(p, end, values[count]))
+            return -1;
+        count++;
+        skipBlanks(p, end);
+    }
+    if (p < end)
+        p++; // Skip the newline
+    return count;
+}
+
+// Get the number of the line starting at p, for an error message. The line itself is not quoted, the reply goes to
+// a client and must not show it the file's contents
+size_t lineNumber(const char *begin, const char *p) {
+    return 1 + static_cast<size_t>(std::count(begin, p, '\n'));
+}
+
+// Parse "n m" and the edge lines, each chunk of lines on its own thread
+bool parseText(const MappedFile &file, const std::string &path, EdgeList &out, std::string &error) {
+    const char *p = file.data, *end = file.data + file.size;
+    size_t header[3];
+    int count = 0;
+    while (p < end && (count = parseLine(p, end, header)) == 0) {} // Skip leading blank and comment lines
+    if (count != 2 || header[0] == 0 || header[0] > INT_MAX) {
+        error = path + ": the first line must be \"n m\" with 1 <= n <= " + std::to_string(INT_MAX);
+        return false;
+    }
+    const size_t n = header[0], m = header[1];
+
+    // Every edge line takes at least 4 bytes ("u v\n"), the header can't promise more edges than the file holds
+    const size_t bodySize = static_cast<size_t>(end - p);
+    if (m > (bodySize + 1) / 4 || n > 2 * m + 1) {
+        error = path + ": header does not match the file size";
+        return false;
+    }
+
+    // Cut the body into chunks that each start at the beginning of a line
+    const size_t numChunks = chunkCount(bodySize);
+    std::vector<const char *> bounds(numChunks + 1, end);
+    bounds[0] = p;
+    for (size_t c = 1; c < numChunks; c++) {
+        const char *b = std::max(p + bodySize * c / numChunks, bounds[c - 1]);
+        const char *eol = static_cast<const char *>(memchr(b, '\n', static_cast<size_t>(end - b)));
+        bounds[c] = eol == nullptr ? end : eol + 1;
+    }
+
+    std::vector<std::vector<Edge>> parts(numChunks);
+    std::vector<std::string> errors(numChunks);
+    std::vector<const char *> errorLines(numChunks, nullptr);
+    parallelFor(numChunks, [&](size_t c) {
+        const char *q = bounds[c], *stop = bounds[c + 1];
+        parts[c].reserve(std::min(m / numChunks, static_cast<size_t>(stop - q) / 4) + 1); // Bounded by the chunk
+        size_t v[3];
+        while (q < stop) {
+            const char *line = q;
+            int k = parseLine(q, stop, v);
+            if (k == 0)
+                continue; // Blank or comment
+            if (k < 2) {
+                errors[c] = "invalid edge line";
+                errorLines[c] = line;
+                return;
+            }
+            if (k == 2)
+                v[2] = 1; // No weight given
+            if (v[0] == 0 || v[1] == 0 || v[0] > n || v[1] > n) {
+                errors[c] = "edge outside the graph";
+                errorLines[c] = line;
+                return;
+            }
+            parts[c].emplace_back(v[0] - 1, v[1] - 1, v[2]);
+        }
+    });
+
+    // Report the first error in file order, then join the chunks
+    size_t total = 0;
+    for (size_t c = 0; c < numChunks; c++) {
+        if (!errors[c].empty()) {
+            error = path + ": line " + std::to_string(lineNumber(file.data, errorLines[c])) + ": " + errors[c];
+            return false;
+        }
+        total += parts[c].size();
+    }
+    if (total != m) {
+        error = path + ": expected " + std::to_string(m) + " edges, found " + std::to_string(total);
+        return false;
+    }
+    std::vector<size_t> start(numChunks, 0);
+    for (size_t c = 1; c < numChunks; c++)
+        start[c] = start[c - 1] + parts[c - 1].size();
+    out.numVertices = n;
+    out.edges.resize(total);
+    parallelFor(numChunks, [&](size_t c) {
+        std::copy(parts[c].begin(), parts[c].end(), out.edges.begin() + static_cast<std::ptrdiff_t>(start[c]));
+    });
+    return true;
+}
+
+// Decode the packed records, each chunk of records on its own thread
+bool parseBinary(const MappedFile &file, const std::string &path, EdgeList &out, std::string &error) {
+    if (file.size < EDGE_LIST_HEADER_SIZE) {
+        error = path + ": truncated header";
+        return false;
+    }
+    const size_t n = loadLE32(file.data + 4), m = loadLE32(file.data + 8);
+    if (n == 0 || n > INT_MAX || n > 2 * m + 1 || file.size != EDGE_LIST_HEADER_SIZE + m * EDGE_LIST_RECORD_SIZE) {
+        error = path + ": header does not match the file size";
+        return false;
+    }
+    const char *records = file.data + EDGE_LIST_HEADER_SIZE;
+    const size_t numChunks = chunkCount(m * EDGE_LIST_RECORD_SIZE);
+    std::vector<std::string> errors(numChunks);
+    out.numVertices = n;
+    out.edges.resize(m);
+    parallelFor(numChunks, [&](size_t c) {
+        for (size_t i = m * c / numChunks; i < m * (c + 1) / numChunks; i++) {
+            const char *r = records + i * EDGE_LIST_RECORD_SIZE;
+            size_t u = loadLE32(r), v = loadLE32(r + 4), w = loadLE32(r + 8);
+            if (u == 0 || v == 0 || u > n || v > n) {
+                errors[c] = "record " + std::to_string(i) + " is outside the graph";
+                return;
+            }
+            out.edges[i] = Edge(u - 1, v - 1, w);
+        }
+    });
+    for (const std::string &e : errors) {
+        if (!e.empty()) {
+            error = path + ": " + e;
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+// Read a text or binary edge-list file
+bool readEdgeList(const std::string &path, EdgeList &out, std::string &error) {
+    MappedFile file;
+    if (!file.open(path, error))
+        return false;
+    out = EdgeList();
+    if (file.size >= sizeof EDGE_LIST_MAGIC && memcmp(file.data, EDGE_LIST_MAGIC, sizeof EDGE_LIST_MAGIC) == 0)
+        return parseBinary(file, path, out, error);
+    return parseText(file, path, out, error);
+}
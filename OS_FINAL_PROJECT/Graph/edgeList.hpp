@@ -0,0 +1,34 @@
+#pragma once
+#include "edge.hpp"
+#include <string>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+/*
+ * Edge-list files for bulk graph loading. Vertices are numbered 1..n in both formats, like the newgraph command.
+ *
+ * Text:    a header line "n m" followed by m lines "u v w" (w may be omitted and defaults to 1).
+ *          Blank lines and lines starting with '#' are skipped.
+ * Binary:  the magic "GRPH", then n and m, then m packed records (u, v, w). Every integer is an unsigned
+ *          32-bit little-endian value, the same record layout as the binary protocol.
+ *
+ * The header has to fit the file: m can't exceed the edges the file has room for, and n can't exceed 2m + 1.
+ * Vertices beyond what the edges can reach would only be isolated, and would let a tiny file allocate a huge graph.
+ *
+ * The file is memory mapped and cut into chunks that are parsed in parallel, so loading is bounded by the disk
+ * rather than by a single reader.
+ */
+
+const char EDGE_LIST_MAGIC[4] = {'G', 'R', 'P', 'H'}; // Binary edge-list signature
+const size_t EDGE_LIST_HEADER_SIZE = 12;              // Magic, n, m
+const size_t EDGE_LIST_RECORD_SIZE = 12;              // Packed (u, v, w) record
+
+// Contents of an edge-list file, vertex ids are 0-based
+struct EdgeList {
+    size_t numVertices = 0;
+    std::vector<Edge> edges;
+};
+
+// Read a text or binary edge-list file, the format is picked by the magic. Returns false and sets error on failure.
+bool readEdgeList(const std::string &path, EdgeList &out, std::string &error);
@@ -1,29 +1,74 @@
 #include "graph.hpp"
+#include "edgeList.hpp"
+#include "../DataStruct/parallel.hpp"
+#include <atomic>
+#include <random>
+#include <climits>
+#include <stdexcept>
+
+namespace {
+// splitmix64 finaliser, every input bit affects every output bit
+uint64_t mix(uint64_t x){
+    x += 0x9E3779B97F4A7C15ull;
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ull;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBull;
+    return x ^ (x >> 31);
+}
+
+// Seed of the content hashes, drawn once per process so colliding graphs can't be prepared in advance
+uint64_t hashSeed(){
+    static const uint64_t seed = [](){
+        std::random_device random;
+        return (static_cast<uint64_t>(random()) << 32) ^ random();
+    }();
+    return seed;
+}
+
+// Content hash of a vertex id, odd inputs so it never matches the first step of an edge hash
+uint64_t vertexTerm(size_t id){
+    return mix((static_cast<uint64_t>(id) * 2 + 1) ^ hashSeed());
+}
+
+// Content hash of the undirected edge (u, v) with weight w, the same in both directions
+uint64_t edgeTerm(size_t u, size_t v, size_t w){
+    if (u > v)
+        std::swap(u, v);
+    return mix(mix(mix((static_cast<uint64_t>(u) * 2) ^ hashSeed()) ^ v) ^ w);
+}
+}
 
-// Check if the graph is connected using BFS
+// Check if the graph is connected, O(1) while only edges were added since the last check
 bool Graph::isConnected() const
 { 
-    size_t n = numVertices(); // Get the number of vertices
-    std::vector<std::vector<size_t>> mat = adjacencyMatrix(); // Get the adjacency matrix
-    std::vector<bool> visited(n, false); // Track visited vertices
-    std::queue<size_t> q; // Queue for BFS
-    q.push(0); // Start from the first vertex
-    visited[0] = true; // Mark the first vertex as visited
-    size_t count = 1; // Count of visited vertices
-    
-    while (!q.empty()){
-        size_t curr = q.front(); // Get the current vertex
-        q.pop();
-        for (size_t i = 0; i < n; i++){
-            // Check for an edge and whether the vertex is unvisited
-            if (mat[curr][i] != INF && !visited[i]){
-                visited[i] = true; // Mark as visited
-                q.push(i); // Add to queue
-                count++; // Increment count of visited vertices
+    if (!componentsValid || components.size() != vertices.size())
+        rebuildComponents(); // Components were invalidated by a removal, rebuild them
+    return numComponents <= 1; // Connected if everything is in a single component
+}
+
+// Rebuild the connected components from the adjacency lists, O(V + E)
+void Graph::rebuildComponents() const
+{
+    if (!denseIds())
+        throw std::logic_error("Graph: vertex ids are not 0..n-1, components can't be indexed by them");
+    components = UnionFind(vertices.size());
+    numComponents = vertices.size();
+    for (const auto &pair : vertices){
+        size_t u = static_cast<size_t>(pair.first);
+        for (const auto &adj : pair.second.getAdj()){
+            // Merge the endpoints, every merge removes one component
+            if (u < adj.first && components.find(u) != components.find(adj.first)){
+                components.Union(u, adj.first);
+                numComponents--;
             }
         }
     }
-    return count == n; // Check if all vertices are visited
+    componentsValid = true;
+}
+
+// Check that the vertex ids are exactly 0..n-1, the map is ordered so the first and last keys bound them
+bool Graph::denseIds() const
+{
+    return vertices.empty() || (vertices.begin()->first == 0 && static_cast<size_t>(vertices.rbegin()->first) == vertices.size() - 1);
 }
 
 // Constructor to create an empty graph
@@ -31,34 +76,147 @@ Graph::Graph() :
     vertices(), 
     edges(), 
     distances(), 
-    parent() {}
+    parent(),
+    components(0),
+    numComponents(0),
+    componentsValid(false) {}
 
+// Constructor to create a graph with vertices 0..n-1 and no edges
+Graph::Graph(size_t n) :
+    vertices(),
+    edges(),
+    distances(),
+    parent(),
+    components(0),
+    numComponents(0),
+    componentsValid(false){
+    for (size_t i = 0; i < n; i++){
+        vertices[static_cast<int>(i)] = Vertex(i); // Store vertex by ID
+        contentSum += vertexTerm(i);
+    }
+}
 
+// Constructor to create a graph with vertices 0..n-1 from an edge list
+Graph::Graph(size_t n, const std::vector<Edge> &edgeList) :
+    vertices(),
+    edges(),
+    distances(),
+    parent(),
+    components(0),
+    numComponents(0),
+    componentsValid(false){
+    if (n > static_cast<size_t>(INT_MAX))
+        throw std::invalid_argument("Graph: at most " + std::to_string(INT_MAX) + " vertices");
+    for (const Edge &e : edgeList){
+        if (e.getStart() >= n || e.getEnd() >= n)
+            throw std::invalid_argument("Graph: edge (" + std::to_string(e.getStart()) + ", " + std::to_string(e.getEnd()) + ") outside a graph of " + std::to_string(n) + " vertices");
+    }
+    std::vector<Vertex *> slots(n); // Direct access to the vertices, the map is not touched by the workers
+    for (size_t i = 0; i < n; i++){
+        auto it = vertices.emplace_hint(vertices.end(), static_cast<int>(i), Vertex(i));
+        slots[i] = &it->second;
+        contentSum += vertexTerm(i);
+    }
+    const size_t E = edgeList.size();
+    auto low = [&edgeList](size_t i){ return std::min(edgeList[i].getStart(), edgeList[i].getEnd()); };
+    auto high = [&edgeList](size_t i){ return std::max(edgeList[i].getStart(), edgeList[i].getEnd()); };
+
+    // Bucket the edges by their smaller endpoint, keeping the input order inside every bucket
+    std::vector<size_t> offsets(n + 1, 0);
+    for (size_t i = 0; i < E; i++)
+        offsets[low(i) + 1]++;
+    for (size_t u = 0; u < n; u++)
+        offsets[u + 1] += offsets[u];
+    std::vector<size_t> order(E), next(offsets.begin(), offsets.end() - 1);
+    for (size_t i = 0; i < E; i++)
+        order[next[low(i)]++] = i;
+
+    // Keep the last occurrence of every undirected edge, like repeated addEdge calls
+    std::vector<char> keep(E, 0);
+    parallelFor(n, [&](size_t u){
+        auto first = order.begin() + static_cast<std::ptrdiff_t>(offsets[u]);
+        auto last = order.begin() + static_cast<std::ptrdiff_t>(offsets[u + 1]);
+        std::stable_sort(first, last, [&high](size_t a, size_t b){ return high(a) < high(b); });
+        for (auto it = first; it != last; it++){
+            if (it + 1 == last || high(*(it + 1)) != high(*it))
+                keep[*it] = 1;
+        }
+    });
+
+    // Gather the kept edges of every vertex, then build the vertices independently of each other
+    std::vector<size_t> degree(n + 1, 0);
+    size_t kept = 0;
+    for (size_t i = 0; i < E; i++){
+        if (!keep[i]) continue;
+        kept++;
+        degree[edgeList[i].getStart() + 1]++;
+        if (edgeList[i].getStart() != edgeList[i].getEnd())
+            degree[edgeList[i].getEnd() + 1]++; // A self loop is listed once
+    }
+    for (size_t u = 0; u < n; u++)
+        degree[u + 1] += degree[u];
+    std::vector<size_t> incident(degree[n]);
+    next.assign(degree.begin(), degree.end() - 1);
+    edges.reserve(kept);
+    for (size_t i = 0; i < E; i++){
+        if (!keep[i]) continue;
+        const Edge &e = edgeList[i];
+        incident[next[e.getStart()]++] = i;
+        if (e.getStart() != e.getEnd())
+            incident[next[e.getEnd()]++] = i;
+        edges.insert(e);
+        contentSum += edgeTerm(e.getStart(), e.getEnd(), e.getWeight());
+    }
+    parallelFor(n, [&](size_t u){
+        std::vector<Edge> list;
+        list.reserve(degree[u + 1] - degree[u]);
+        for (size_t k = degree[u]; k < degree[u + 1]; k++)
+            list.push_back(edgeList[incident[k]]);
+        slots[u]->assignEdges(std::move(list));
+    });
+}
+
+// Load a text or binary edge-list file
+Graph *Graph::load(const std::string &path, std::string &error){
+    EdgeList list;
+    if (!readEdgeList(path, list, error))
+        return nullptr;
+    return new Graph(list.numVertices, list.edges);
+}
 
 // Constructor to create a graph from a set of vertices that may already contain edges
 Graph::Graph(std::unordered_set<Vertex> v) :
     vertices(),
     edges(), 
     distances(), 
-    parent(){
+    parent(),
+    components(0),
+    numComponents(0),
+    componentsValid(false){
     // Add vertices to the graph
     for (auto vertex : v)
         vertices[vertex.getId()] = vertex; // Store vertex by ID
     // Add edges to the graph
     for (auto vertex : v){
-        for (auto e : vertex) {// Iterate through edges of vertex
+        for (const auto &e : vertex) {// Iterate through edges of vertex
             // Check if the other vertex of the edge is in the set
-            if (v.find(e.getOther(vertex)) != v.end())
+            if (v.find(Vertex(e.getOther(vertex.getId()))) != v.end())
                 edges.insert(e); // Add edge if valid
         }
     }
+    if (!denseIds())
+        throw std::invalid_argument("Graph: vertex ids must be 0..n-1");
+    rehashContent();
 }
 
 // Copy constructor with option to not copy edges
 Graph::Graph(const Graph &other, bool copyEdges) : vertices(),
     edges(), 
     distances(), 
-    parent()
+    parent(),
+    components(0),
+    numComponents(0),
+    componentsValid(false)
 {   
     // Copy all vertices
     for (const auto &pair : other.vertices){
@@ -99,6 +257,59 @@ Graph::Graph(const Graph &other, bool copyEdges) : vertices(),
             pair.second.getAdj().clear(); // Clear adjacency list
         }
     }
+    rehashContent();
+}
+
+// Get a full copy for copy-on-write
+Graph *Graph::clone() const{
+    Graph *g = new Graph(*this, true);
+    g->graphVersion = graphVersion; // Same contents, the responses cached for this version still apply
+    g->components = components;
+    g->numComponents = numComponents;
+    g->componentsValid = componentsValid;
+    if (mstTracker)
+        g->mstTracker.reset(new DynamicMST(*mstTracker)); // Keeps following the edits of the copy
+    return g;
+}
+
+// Draw the next graph version, graphs are created and changed from several threads
+uint64_t Graph::nextVersion(){
+    static std::atomic<uint64_t> counter(0);
+    return counter.fetch_add(1, std::memory_order_relaxed) + 1;
+}
+
+// Get the version of the graph
+uint64_t Graph::version() const{
+    return graphVersion;
+}
+
+// Get the hash of the contents
+uint64_t Graph::contentHash() const{
+    return contentSum;
+}
+
+// Recompute the content hash from the vertices and their adjacency lists, O(V + E)
+void Graph::rehashContent(){
+    contentSum = 0;
+    for (const auto &pair : vertices){
+        size_t u = static_cast<size_t>(pair.first);
+        contentSum += vertexTerm(u);
+        for (const auto &adj : pair.second.getAdj())
+            if (u <= adj.first) // Every edge is in both adjacency lists, a self loop in one
+                contentSum += edgeTerm(u, adj.first, adj.second);
+    }
+}
+
+// Get the vertex with the given id, creating it if it is new. Only the next id can be new, so ids stay 0..n-1
+Vertex &Graph::vertexAt(int id){
+    auto it = vertices.find(id);
+    if (it == vertices.end()){
+        if (id < 0 || static_cast<size_t>(id) != vertices.size())
+            throw std::out_of_range("Graph: vertex " + std::to_string(id) + " is neither in the graph nor the next id " + std::to_string(vertices.size()));
+        it = vertices.emplace(id, Vertex()).first;
+        contentSum += vertexTerm(static_cast<size_t>(id));
+    }
+    return it->second;
 }
 
 // Get the number of vertices in the graph
@@ -106,6 +317,11 @@ size_t Graph::numVertices() const{
     return vertices.size(); // Return size of vertices map
 }
 
+// Get the number of undirected edges in the graph
+size_t Graph::numEdges() const{
+    return edges.size(); // One entry per undirected edge
+}
+
 // Get an iterator for the start of edges in the graph
 std::unordered_set<Edge>::iterator Graph::edgesBegin(){
     return edges.begin(); // Return iterator to the beginning of edges
@@ -117,26 +333,80 @@ std::unordered_set<Edge>::iterator Graph::edgesEnd(){
 }
 
 // Add an edge to the graph, the edge is directed from start to end
-void Graph::addEdge(Edge e){
+void Graph::addEdge(const Edge &e){
     cleanDistParent(); // Clean up distance and parent matrices
-    vertices[e.getStart().getId()].addEdge(e); // Add edge to start vertex
-    vertices[e.getEnd().getId()].addEdge(e); // Add edge to end vertex
+    graphVersion = nextVersion(); // Results cached for the previous contents no longer apply
+    if (e.getStart() > static_cast<size_t>(INT_MAX) || e.getEnd() > static_cast<size_t>(INT_MAX))
+        throw std::out_of_range("Graph: vertex ids are at most " + std::to_string(INT_MAX));
+    int u = static_cast<int>(e.getStart()), v = static_cast<int>(e.getEnd());
+    // Count new vertices in the content hash, and take out the old weight when the edge is replaced
+    auto old = vertexAt(u).getAdj().find(e.getEnd());
+    if (old != vertices[u].getAdj().end())
+        contentSum -= edgeTerm(e.getStart(), e.getEnd(), old->second);
+    vertexAt(v);
+    contentSum += edgeTerm(e.getStart(), e.getEnd(), e.getWeight());
+    vertices[u].addEdge(e); // Add edge to start vertex
+    vertices[v].addEdge(e); // Add edge to end vertex
     // Update adjacency list for both vertices
-    vertices[e.getStart().getId()].getAdj()[e.getOther(vertices[e.getStart().getId()]).getId()] = e.getWeight();
-    vertices[e.getEnd().getId()].getAdj()[e.getOther(vertices[e.getEnd().getId()]).getId()] = e.getWeight();
+    vertices[u].getAdj()[e.getEnd()] = e.getWeight();
+    vertices[v].getAdj()[e.getStart()] = e.getWeight();
+    // Keep a single entry per undirected edge, carrying the same weight as the adjacency lists
+    edges.erase(e);
+    edges.erase(Edge(e.getEnd(), e.getStart(), e.getWeight()));
     edges.insert(e); // Insert edge into the edges set
+    // Adding an edge can only merge components, keep them up to date
+    if (componentsValid){
+        if (e.getStart() >= components.size() || e.getEnd() >= components.size())
+            componentsValid = false; // A new vertex id appeared, rebuild on the next check
+        else if (components.find(e.getStart()) != components.find(e.getEnd())){
+            components.Union(e.getStart(), e.getEnd());
+            numComponents--;
+        }
+    }
+    if (mstTracker)
+        mstTracker->insertEdge(e.getStart(), e.getEnd(), e.getWeight(), *this); // Cycle rule on the tracked tree
 }
 
 // Remove an edge from the graph
-void Graph::removeEdge(Edge e){
+void Graph::removeEdge(const Edge &e){
     cleanDistParent(); // Clean up distance and parent matrices
-    vertices[e.getStart().getId()].removeEdge(e); // Remove edge from start vertex
-    vertices[e.getEnd().getId()].removeEdge(e); // Remove edge from end vertex
+    graphVersion = nextVersion();
+    if (e.getStart() > static_cast<size_t>(INT_MAX) || e.getEnd() > static_cast<size_t>(INT_MAX))
+        throw std::out_of_range("Graph: vertex ids are at most " + std::to_string(INT_MAX));
+    int u = static_cast<int>(e.getStart()), v = static_cast<int>(e.getEnd());
+    Edge reverse(e.getEnd(), e.getStart(), e.getWeight());
+    // Removing an existing edge may split a component, rebuild on the next check
+    auto old = vertexAt(u).getAdj().find(e.getEnd());
+    bool existed = old != vertices[u].getAdj().end();
+    vertexAt(v);
+    if (existed){
+        componentsValid = false;
+        contentSum -= edgeTerm(e.getStart(), e.getEnd(), old->second);
+    }
+    // Remove edge from both vertices, in whichever direction it was added
+    vertices[u].removeEdge(e);
+    vertices[u].removeEdge(reverse);
+    vertices[v].removeEdge(e);
+    vertices[v].removeEdge(reverse);
     // Erase from adjacency lists
-    vertices[e.getStart().getId()].getAdj().erase(e.getOther(vertices[e.getStart().getId()]).getId());
-    vertices[e.getEnd().getId()].getAdj().erase(e.getOther(vertices[e.getEnd().getId()]).getId());
+    vertices[u].getAdj().erase(e.getEnd());
+    vertices[v].getAdj().erase(e.getStart());
     edges.erase(e); // Erase edge from edges set
-    edges.erase(Edge(e.getEnd(), e.getStart(), e.getWeight())); // Remove reverse edge if it's undirected
+    edges.erase(reverse); // Remove reverse edge if it's undirected
+    if (existed && mstTracker)
+        mstTracker->removeEdge(e.getStart(), e.getEnd(), *this); // A tree edge gets its replacement
+}
+
+// Keep mst up to date across edge updates
+void Graph::trackMST(const Graph &mst){
+    mstTracker.reset(new DynamicMST(mst));
+}
+
+// Get a copy of the tracked MST
+Graph *Graph::trackedMST() const{
+    if (!mstTracker || !mstTracker->valid())
+        return nullptr; // Never computed, or an update the tracker can't follow
+    return mstTracker->tree();
 }
 
 // Add an edge using vertex references and weight
@@ -155,14 +425,28 @@ std::map<int, Vertex>::iterator Graph::end(){
     return vertices.end(); // Return iterator to the end of vertices
 }
 
+// Const iterators over the vertices in the graph
+std::map<int, Vertex>::const_iterator Graph::begin() const{
+    return vertices.begin();
+}
+
+std::map<int, Vertex>::const_iterator Graph::end() const{
+    return vertices.end();
+}
+
+// Build an immutable CSR snapshot of the graph
+CSRGraph Graph::snapshot() const{
+    return CSRGraph(*this);
+}
+
 // Get the adjacency matrix of the graph
 std::vector<std::vector<size_t>> Graph::adjacencyMatrix() const{
     size_t n = numVertices(); // Get number of vertices
     std::vector<std::vector<size_t>> mat(n, std::vector<size_t>(n, INF)); // Initialize adjacency matrix with INF
-    for (auto Edge : edges) // Iterate over edges
+    for (const auto &Edge : edges) // Iterate over edges
     {
-        mat[Edge.getStart().getId()][Edge.getEnd().getId()] = Edge.getWeight(); // Set weight for directed edge
-        mat[Edge.getEnd().getId()][Edge.getStart().getId()] = Edge.getWeight(); // Set weight for reverse edge (if undirected)
+        mat[Edge.getStart()][Edge.getEnd()] = Edge.getWeight(); // Set weight for directed edge
+        mat[Edge.getEnd()][Edge.getStart()] = Edge.getWeight(); // Set weight for reverse edge (if undirected)
     }
     for (size_t i = 0; i < n; i++) {
         mat[i][i] = 0; // Set diagonal to 0 (distance to itself)
@@ -172,7 +456,7 @@ std::vector<std::vector<size_t>> Graph::adjacencyMatrix() const{
 
 // Get a vertex by its ID
 Vertex &Graph::getVertex(int id){
-    return vertices[id]; // Return vertex reference
+    return vertexAt(id); // Return vertex reference, a new vertex counts in the content hash
 }
 
 const Vertex &Graph::getVertex(int id) const{
@@ -207,12 +491,10 @@ std::string Graph::longestPath(const std::vector<std::vector<size_t>> &dist) con
 }
 
 
-// Get the distances and parent matrices
+// Get the distances and parent matrices, the dense matrices are only built here when they are not cached
 std::pair<std::vector<std::vector<size_t>>, std::vector<std::vector<size_t>>> Graph::getDistances() const{
-    if (this->distances.empty())
-        throw std::runtime_error("Distances not calculated"); // Check if distances exist
-    if (this->parent.empty())
-        throw std::runtime_error("Parent not calculated"); // Check if parent exists
+    if (this->distances.empty() || this->parent.empty())
+        return isTree() ? treeDistances() : floydWarshall(); // Build them on request
     return std::make_pair(distances, parent); // Return distances and parents
 }
 
@@ -235,26 +517,34 @@ std::string Graph::shortestPath(size_t start, size_t end, const std::vector<std:
     if (start >= numVertices() || end >= numVertices()) {
         return "Invalid vertices\n";
     }
-    if (parents[start][end] == INF){
-        return "No path exists between " + std::to_string(start) + " and " + std::to_string(end) + "\n";
+    std::string path;
+    appendPath(path, start, end, parents[start], dist[start][end]);
+    return path;
+}
+
+// Append the path from start to end to out, given the parent row of start
+void Graph::appendPath(std::string &out, size_t start, size_t end, const std::vector<size_t> &parentRow, size_t distance){
+    if (parentRow[end] == INF){
+        out += "No path exists between " + std::to_string(start) + " and " + std::to_string(end) + "\n";
+        return;
     }
-    std::string path = "Shortest path from " + std::to_string(start) + " to " + std::to_string(end) + " is: ";
-    std::vector<int> pathVec;
+    out += "Shortest path from " + std::to_string(start) + " to " + std::to_string(end) + " is: ";
+    std::vector<size_t> pathVec;
     pathVec.push_back(end);
     size_t current = end;
     while (current != start){
-        current = parents[start][current];
+        current = parentRow[current];
         pathVec.push_back(current);
     }
     // using reverse iterator to get the path in the correct order
     for (auto it = pathVec.rbegin(); it != pathVec.rend(); it++){
-        path += std::to_string(*it) + " -> ";
+        out += std::to_string(*it) + " -> ";
     }
-    path.pop_back();
-    path.pop_back();
-    path.pop_back(); // Remove the last arrow
+    out.pop_back();
+    out.pop_back();
+    out.pop_back(); // Remove the last arrow
 
-    return path + " with a distance of " + std::to_string(dist[start][end]) + "\n";
+    out += " with a distance of " + std::to_string(distance) + "\n";
 }
 
 // gets the shortest path between all vertices in the graph, returns a string with all the paths in the graph for undirected graph
@@ -263,7 +553,7 @@ std::string Graph::allShortestPaths(const std::vector<std::vector<size_t>> &dist
     std::string paths = "Shortest paths between all vertices in the graph are: \n";
     for (size_t i = 0; i < n; i++){
         for (size_t j = i + 1; j < n; j++){
-            paths += shortestPath(i, j, dist, parent);
+            appendPath(paths, i, j, parent[i], dist[i][j]);
         }
     }
     return paths;
@@ -272,80 +562,258 @@ std::string Graph::allShortestPaths(const std::vector<std::vector<size_t>> &dist
 // Floyd-Warshall algorithm to compute shortest paths
 std::pair<std::vector<std::vector<size_t>>, std::vector<std::vector<size_t>>> Graph::floydWarshall() const
 {
-    size_t n = numVertices(); // Get number of vertices
-    std::vector<std::vector<size_t>> dist = adjacencyMatrix(); // Get distance matrix from adjacency matrix
-    std::vector<std::vector<size_t>> parent(n, std::vector<size_t>(n, INF)); // Initialize parent matrix
-    // Initialize parent matrix
-    for (size_t i = 0; i < n; i++){
-        for (size_t j = 0; j < n; j++){
-            if (dist[i][j] != INF){
-                parent[i][j] = i; // Set parent to itself if there is an edge
+    return floydWarshall(snapshot()); // Run on a CSR snapshot of the graph
+}
+
+// All-pairs distances of a tree from a snapshot of it
+std::pair<std::vector<std::vector<size_t>>, std::vector<std::vector<size_t>>> Graph::treeDistances() const
+{
+    return treeDistances(snapshot());
+}
+
+// All-pairs distances of a tree: the path between two vertices is unique, so a single traversal
+// from every source gives its whole row of distances and parents, O(V) per source instead of O(V^2)
+std::pair<std::vector<std::vector<size_t>>, std::vector<std::vector<size_t>>> Graph::treeDistances(const CSRGraph &tree)
+{
+    size_t n = tree.numVertices();
+    std::vector<std::vector<size_t>> dist(n, std::vector<size_t>(n, INF)); // INF for vertices in other trees
+    std::vector<std::vector<size_t>> parent(n, std::vector<size_t>(n, INF));
+
+    // Every source only writes its own rows, so the sources run in parallel
+    parallelFor(n, [&tree, &dist, &parent](size_t s) {
+        std::vector<size_t> &d = dist[s];
+        std::vector<size_t> &p = parent[s];
+        std::vector<uint32_t> stack; // Iterative DFS, trees can be deeper than the call stack
+        d[s] = 0;
+        p[s] = s;
+        stack.push_back(static_cast<uint32_t>(s));
+        while (!stack.empty()){
+            size_t u = stack.back();
+            stack.pop_back();
+            const size_t *w = tree.weightsBegin(u);
+            for (const uint32_t *v = tree.neighborsBegin(u); v != tree.neighborsEnd(u); v++, w++){
+                if (d[*v] == INF){ // Not visited yet, u is its predecessor on the path from s
+                    d[*v] = d[u] + *w;
+                    p[*v] = u;
+                    stack.push_back(*v);
+                }
             }
         }
-    }
+    });
+    return {dist, parent};
+}
 
-    // Floyd-Warshall algorithm
-    for (size_t k = 0; k < n; k++){
-        for (size_t i = 0; i < n; i++){
-            for (size_t j = 0; j < n; j++){
-                // Update distance and parent if a shorter path is found
-                if (dist[i][k] != INF && dist[k][j] != INF && dist[i][j] > dist[i][k] + dist[k][j]){
-                    dist[i][j] = dist[i][k] + dist[k][j]; // Update distance
-                    parent[i][j] = parent[k][j]; // Update parent
+//////////////////////////// Lazy metrics ///////////////////////
+
+/*
+ * When the dense matrices are not cached, the metrics below are computed on demand from a CSR snapshot.
+ * On a tree (every MST) they need no all-pairs data at all: the diameter takes two traversals, the
+ * average distance comes from per-edge subtree sizes and each path is read from a single-source traversal.
+ * Other graphs fall back to the dense matrices.
+ */
+
+// Check if the graph is a single tree: connected with exactly V - 1 edges
+bool Graph::isTree() const{
+    return !vertices.empty() && edges.size() == vertices.size() - 1 && isConnected();
+}
+
+// Distances and parents from one source into dist/parent (INF when unreachable).
+// On a tree a plain traversal is exact, otherwise Dijkstra is used. Returns the vertices in the order
+// they were reached, every vertex comes after its parent.
+std::vector<uint32_t> Graph::singleSource(const CSRGraph &g, size_t source, bool tree, std::vector<size_t> &dist, std::vector<size_t> &parent){
+    size_t n = g.numVertices();
+    dist.assign(n, INF);
+    parent.assign(n, INF);
+    std::vector<uint32_t> order;
+    order.reserve(n);
+    dist[source] = 0;
+    parent[source] = source;
+    if (tree){
+        std::vector<uint32_t> stack(1, static_cast<uint32_t>(source)); // Iterative DFS
+        while (!stack.empty()){
+            uint32_t u = stack.back();
+            stack.pop_back();
+            order.push_back(u);
+            const size_t *w = g.weightsBegin(u);
+            for (const uint32_t *v = g.neighborsBegin(u); v != g.neighborsEnd(u); v++, w++){
+                if (dist[*v] == INF){
+                    dist[*v] = dist[u] + *w;
+                    parent[*v] = u;
+                    stack.push_back(*v);
                 }
             }
         }
+        return order;
     }
-
-    return {dist, parent}; // Return distance and parent matrices
+    // Dijkstra with a lazy-deletion min heap of (distance, vertex)
+    std::priority_queue<std::pair<size_t, uint32_t>, std::vector<std::pair<size_t, uint32_t>>, std::greater<std::pair<size_t, uint32_t>>> pq;
+    pq.push({0, static_cast<uint32_t>(source)});
+    while (!pq.empty()){
+        auto top = pq.top();
+        pq.pop();
+        uint32_t u = top.second;
+        if (top.first != dist[u])
+            continue; // Stale entry
+        order.push_back(u);
+        const size_t *w = g.weightsBegin(u);
+        for (const uint32_t *v = g.neighborsBegin(u); v != g.neighborsEnd(u); v++, w++){
+            if (dist[u] + *w < dist[*v]){
+                dist[*v] = dist[u] + *w;
+                parent[*v] = u;
+                pq.push({dist[*v], *v});
+            }
+        }
+    }
+    return order;
 }
 
-// Get the longest path from the precomputed distances
+// Get the longest path, on a tree this is the diameter found with two traversals
 std::string Graph::longestPath() const
 {
-    if (distances.empty()){ // Check if distances are computed
-        std::vector<std::vector<size_t>> dist = getDistances().first; // Get distances
-        return longestPath(dist); // Find longest path
-    }
-    return longestPath(distances); // Use precomputed distances
+    if (!distances.empty()) // Use precomputed distances
+        return longestPath(distances);
+    if (!isTree())
+        return longestPath(getDistances().first);
+
+    CSRGraph g = snapshot();
+    std::vector<size_t> dist, parents;
+    // The vertex farthest from any vertex is an end of a diameter, the vertex farthest from it is the other end
+    singleSource(g, 0, true, dist, parents);
+    size_t a = static_cast<size_t>(std::max_element(dist.begin(), dist.end()) - dist.begin());
+    singleSource(g, a, true, dist, parents);
+    size_t b = static_cast<size_t>(std::max_element(dist.begin(), dist.end()) - dist.begin());
+    size_t maxDist = dist[b];
+    size_t from = maxDist == 0 ? 0 : std::min(a, b), to = maxDist == 0 ? 0 : std::max(a, b);
+    return "Longest path is from " + std::to_string(from) + " to " + std::to_string(to) + " with a distance of " + std::to_string(maxDist);
 }
 
-// Calculate the average distance
+// Calculate the average distance, on a tree every edge is used by size * (n - size) pairs
 double Graph::avgDistance() const{
-    if (distances.empty()){ // Check if distances are computed
-        std::vector<std::vector<size_t>> dist = getDistances().first; // Get distances
-        return avgDistance(dist); // Calculate average distance
+    if (!distances.empty()) // Use precomputed distances
+        return avgDistance(distances);
+    size_t n = numVertices();
+    if (n < 2 || !isTree())
+        return avgDistance(getDistances().first);
+
+    CSRGraph g = snapshot();
+    std::vector<size_t> dist, parents;
+    std::vector<uint32_t> order = singleSource(g, 0, true, dist, parents);
+    std::vector<size_t> subtree(n, 1); // Size of the subtree under every vertex
+    size_t totalDist = 0;
+    // Children come after their parents in the order, walk it backwards to accumulate the sizes
+    for (auto it = order.rbegin(); it != order.rend(); it++){
+        size_t v = *it;
+        if (v == 0)
+            continue;
+        size_t p = parents[v];
+        totalDist += (dist[v] - dist[p]) * subtree[v] * (n - subtree[v]); // Weight of (p, v) times the pairs crossing it
+        subtree[p] += subtree[v];
     }
-    return avgDistance(distances); // Use precomputed distances
+    return static_cast<double>(totalDist) / (n * (n - 1) / 2); // Average over the unordered pairs
 }
 
-// Get all shortest paths
-std::string Graph::allShortestPaths() const{
-    // If distances are not calculated, calculate them
-    if (distances.empty()){
-        // Get the distances between vertices in the graph and the parent matrix
-        std::vector<std::vector<size_t>> dist, parent;
-        std::tie(dist, parent) = floydWarshall(); // Compute distances and parents
-        return allShortestPaths(dist, parent); // Get all shortest paths
+// Get the shortest path between two vertices, only this pair is computed when no matrices are cached
+std::string Graph::shortestPath(size_t start, size_t end) const{
+    if (start >= numVertices() || end >= numVertices()) {
+        return "Invalid vertices\n";
     }
-    return allShortestPaths(distances, parent); // Use precomputed distances
+    if (!distances.empty())
+        return shortestPath(start, end, distances, parent); // Use precomputed distances
+    std::vector<size_t> dist, parents;
+    singleSource(snapshot(), start, isTree(), dist, parents);
+    std::string path;
+    appendPath(path, start, end, parents, dist[end]);
+    return path;
 }
 
-// Get graph statistics
-std::string Graph::stats() const{
+// Append the path lines for every pair to buf, flushing it whenever it reaches chunkSize
+bool Graph::streamPaths(std::string &buf, const std::function<bool(std::string &)> &flush, size_t chunkSize,
+                        const std::vector<std::vector<size_t>> *dist, const std::vector<std::vector<size_t>> *parents) const{
+    CSRGraph g;
+    if (dist == nullptr)
+        g = snapshot(); // Tree, rows come from one traversal per source
+    size_t n = numVertices();
+    std::vector<size_t> distRow, parentRow;
+    for (size_t i = 0; i < n; i++){
+        if (dist == nullptr)
+            singleSource(g, i, true, distRow, parentRow); // Row i of the distance and parent matrices
+        for (size_t j = i + 1; j < n; j++){
+            if (dist == nullptr)
+                appendPath(buf, i, j, parentRow, distRow[j]);
+            else
+                appendPath(buf, i, j, (*parents)[i], (*dist)[i][j]);
+            if (buf.size() >= chunkSize && !flush(buf))
+                return false; // The sink stopped the stream
+        }
+    }
+    return true;
+}
+
+// Stream the shortest paths between all vertices through flush
+bool Graph::streamShortestPaths(const std::function<bool(std::string &)> &flush, size_t chunkSize) const{
     std::vector<std::vector<size_t>> dist, parents;
-    // Get the distances between vertices in the graph and the parent matrix
-    if (distances.empty() || parent.empty()){
+    const std::vector<std::vector<size_t>> *d = nullptr, *p = nullptr;
+    if (!distances.empty()){ // Use precomputed distances
+        d = &distances;
+        p = &parent;
+    }
+    else if (!isTree()){
         std::tie(dist, parents) = floydWarshall(); // Compute distances and parents
+        d = &dist;
+        p = &parents;
     }
-    else{
-        std::tie(dist, parents) = getDistances(); // Use precomputed distances
+    std::string buf = "Shortest paths between all vertices in the graph are: \n";
+    if (!streamPaths(buf, flush, chunkSize, d, p))
+        return false;
+    return buf.empty() || flush(buf);
+}
+
+// Get all shortest paths, on a tree one traversal per source
+std::string Graph::allShortestPaths() const{
+    std::string paths;
+    streamShortestPaths([&paths](std::string &chunk){
+        paths += chunk; // Collect the whole stream
+        chunk.clear();
+        return true;
+    });
+    return paths;
+}
+
+// Stream the graph statistics, the summary goes out before any path is computed
+bool Graph::streamStats(const std::function<bool(std::string &)> &flush, size_t chunkSize) const{
+    std::vector<std::vector<size_t>> dist, parents;
+    const std::vector<std::vector<size_t>> *d = nullptr, *p = nullptr;
+    if (!distances.empty()){ // Use precomputed distances
+        d = &distances;
+        p = &parent;
+    }
+    else if (!isTree()){
+        // No cached matrices and no tree shortcut, compute the matrices once for all the metrics
+        std::tie(dist, parents) = floydWarshall();
+        d = &dist;
+        p = &parents;
     }
-    std::string stats = "Graph with " + std::to_string(numVertices()) + " vertices and " + std::to_string(edges.size()) + " edges\n";
-    stats += "Total weight of edges: " + std::to_string(totalWeight()) + "\n"; // Display total weight
-    stats += longestPath(dist) + "\n"; // Display longest path
-    stats += "The average distance between vertices is: " + std::to_string(avgDistance(dist)) + "\n"; // Display average distance
-    stats += "The shortest paths are: \n" + allShortestPaths(dist, parents) + "\n"; // Display all shortest paths
+    std::string buf = "Graph with " + std::to_string(numVertices()) + " vertices and " + std::to_string(edges.size()) + " edges\n";
+    buf += "Total weight of edges: " + std::to_string(totalWeight()) + "\n"; // Display total weight
+    buf += (d ? longestPath(*d) : longestPath()) + "\n"; // Display longest path
+    buf += "The average distance between vertices is: " + std::to_string(d ? avgDistance(*d) : avgDistance()) + "\n"; // Display average distance
+    buf += "The shortest paths are: \nShortest paths between all vertices in the graph are: \n";
+    if (!flush(buf)) // Send the summary right away
+        return false;
+    if (!streamPaths(buf, flush, chunkSize, d, p)) // Display all shortest paths
+        return false;
+    buf += "\n";
+    return flush(buf);
+}
+
+// Get graph statistics
+std::string Graph::stats() const{
+    std::string stats;
+    streamStats([&stats](std::string &chunk){
+        stats += chunk; // Collect the whole stream
+        chunk.clear();
+        return true;
+    });
     return stats; // Return statistics
 }
 
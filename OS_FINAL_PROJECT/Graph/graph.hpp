@@ -1,6 +1,9 @@
 #pragma once
 #include "vertex.hpp"
 #include "edge.hpp"
+#include "csr.hpp"
+#include "dynamicMST.hpp"
+#include "../DataStruct/data_structures.hpp"
 #include <map>
 #include <unordered_set>
 #include <vector>
@@ -8,6 +11,8 @@
 #include <queue>
 #include <cstddef>
 #include <memory>
+#include <functional>
+#include <string>
 #define INF static_cast<size_t>(-1)
 
 class Graph
@@ -32,14 +37,63 @@ private:
 
     void cleanDistParent();
 
+    // Connected components over the adjacency lists, maintained incrementally by addEdge.
+    // A removal invalidates them and the next isConnected() rebuilds them in O(V + E).
+    mutable UnionFind components;
+    mutable size_t numComponents;
+    mutable bool componentsValid;
+
+    // Rebuild the connected components from the adjacency lists
+    void rebuildComponents() const;
+
+    // Minimum spanning forest maintained by addEdge and removeEdge once trackMST seeded it, null otherwise
+    std::unique_ptr<DynamicMST> mstTracker;
+
+    // Version of the contents, drawn from one counter shared by all graphs so no two states share a version
+    uint64_t graphVersion = nextVersion();
+    static uint64_t nextVersion();
+
+    // Sum of one hash per vertex id and per undirected (u, v, weight) edge, kept up to date by addEdge and removeEdge.
+    // A sum doesn't depend on the order the graph was built in, and an edge is taken out by subtracting its hash.
+    uint64_t contentSum = 0;
+    // Recompute contentSum from the vertices and their adjacency lists
+    void rehashContent();
+    // Get the vertex with the given id, creating it and counting it in contentSum if it is new.
+    // Throws out_of_range for a new id other than numVertices(), the ids stay 0..n-1 for the dense arrays
+    Vertex &vertexAt(int id);
+
+    // Check if the graph is a single tree (connected with V - 1 edges), the lazy metrics have exact shortcuts for it
+    bool isTree() const;
+    // Distances and parents from one source over a snapshot, returns the vertices in the order they were reached
+    static std::vector<uint32_t> singleSource(const CSRGraph &g, size_t source, bool tree, std::vector<size_t> &dist, std::vector<size_t> &parent);
+    // Append the path from start to end to out, given the parent row of start
+    static void appendPath(std::string &out, size_t start, size_t end, const std::vector<size_t> &parentRow, size_t distance);
+    // Append the path lines for every pair to buf, handing buf to flush whenever it reaches chunkSize.
+    // Uses the given matrices, or one traversal per source on a tree when they are null.
+    bool streamPaths(std::string &buf, const std::function<bool(std::string &)> &flush, size_t chunkSize,
+                     const std::vector<std::vector<size_t>> *dist, const std::vector<std::vector<size_t>> *parents) const;
+
    
     
 
 
 public:
+    // Default size of the chunks handed to a stream sink
+    static const size_t STREAM_CHUNK = 64 * 1024;
+
     // Constructor to create an empty graph
     Graph();
 
+    // Constructor to create a graph with vertices 0..n-1 and no edges
+    explicit Graph(size_t n);
+
+    // Constructor to create a graph with vertices 0..n-1 from an edge list in one pass.
+    // Same result as calling addEdge for every edge in order: a repeated edge keeps its last weight.
+    Graph(size_t n, const std::vector<Edge> &edgeList);
+
+    // Load a text or binary edge-list file (see edgeList.hpp). Returns nullptr and sets error on failure.
+    static Graph *load(const std::string &path, std::string &error);
+
 
 
 
@@ -49,17 +103,30 @@ public:
     //Copy constructor with option to not copy edges
     Graph(const Graph &other, bool copyEdges = false);
 
+    // Get a full copy to edit in place of this graph while another thread still reads this one (copy-on-write).
+    // The copy keeps the version, the connected components and the tracked MST.
+    Graph *clone() const;
+
+    // Get the version of the graph, a new one on every addEdge and removeEdge and unique across all graphs
+    uint64_t version() const;
+    // Get the hash of the contents, equal for any two graphs with the same vertex ids and weighted edges however
+    // they were built or edited. Seeded per process, and a sum of hashes: different graphs may still collide, compare
+    // them with CSRGraph::matches before sharing anything by hash
+    uint64_t contentHash() const;
+
     // Get the number of vertices in the graph
     size_t numVertices() const;
+    // Get the number of undirected edges in the graph
+    size_t numEdges() const;
     // Get an iterator for the start of edges in the graph
     std::unordered_set<Edge>::iterator edgesBegin();
     // Get an iterator for the end of edges in the graph
     std::unordered_set<Edge>::iterator edgesEnd();
 
     // Add an edge to the graph, the edge is directed from start to end
-    void addEdge(Edge e);
+    void addEdge(const Edge &e);
     // Remove an edge from the graph
-    void removeEdge(Edge e);
+    void removeEdge(const Edge &e);
  
     //add edge to the graph by vertices
     void addEdge(Vertex &start, Vertex &end, size_t weight = 1);
@@ -70,12 +137,27 @@ public:
     // Get an iterator for the end of the vertices in the graph
     std::map<int, Vertex>::iterator end();
 
+    // Const iterators over the vertices in the graph
+    std::map<int, Vertex>::const_iterator begin() const;
+    std::map<int, Vertex>::const_iterator end() const;
+
+    // Build an immutable CSR snapshot of the graph
+    CSRGraph snapshot() const;
+
     // Get the adjacency matrix of the graph
     std::vector<std::vector<size_t>> adjacencyMatrix() const;
 
     // Check if the graph is connected
     bool isConnected() const;
 
+    // Check that the vertex ids are exactly 0..numVertices()-1, the snapshots and components index arrays with them
+    bool denseIds() const;
+
+    // Keep mst, a minimum spanning forest of this graph computed by a strategy, up to date across edge updates
+    void trackMST(const Graph &mst);
+    // Get a copy of the tracked MST, nullptr when none is tracked or an update invalidated it
+    Graph *trackedMST() const;
+
     // Get a vertex by its ID
     Vertex &getVertex(int id);
     const Vertex &getVertex(int id) const;
@@ -85,6 +167,10 @@ public:
 
     std::string stats() const;
 
+    // Stream the statistics through flush in chunks of about chunkSize bytes, the summary is flushed first.
+    // flush receives the pending text, must consume it (leave it empty) and returns false to stop the stream.
+    bool streamStats(const std::function<bool(std::string &)> &flush, size_t chunkSize = STREAM_CHUNK) const;
+
     // Get total weight of the graph
     size_t totalWeight() const;
     
@@ -93,10 +179,22 @@ public:
 
      // Get the distances between vertices in the graph and the parent matrix
     std::pair<std::vector<std::vector<size_t>>, std::vector<std::vector<size_t>>> floydWarshall() const;
+    // Floyd-Warshall over a CSR snapshot
+    static std::pair<std::vector<std::vector<size_t>>, std::vector<std::vector<size_t>>> floydWarshall(const CSRGraph &csr);
+
+    // All-pairs distances and parents of a tree (or forest) in O(V^2), one traversal per source.
+    // Fills the same matrices as floydWarshall() for graphs without cycles.
+    std::pair<std::vector<std::vector<size_t>>, std::vector<std::vector<size_t>>> treeDistances() const;
+    static std::pair<std::vector<std::vector<size_t>>, std::vector<std::vector<size_t>>> treeDistances(const CSRGraph &tree);
 
+    // Metrics, computed lazily from the graph when the dense matrices are not cached
     std::string longestPath() const;
     std::string allShortestPaths() const;
     double avgDistance() const;
+    // Get the shortest path between two vertices, only this pair is computed
+    std::string shortestPath(size_t start, size_t end) const;
+    // Stream the shortest paths between all vertices through flush, O(V) memory on a tree
+    bool streamShortestPaths(const std::function<bool(std::string &)> &flush, size_t chunkSize = STREAM_CHUNK) const;
 
 };
 
@@ -11,7 +11,7 @@ size_t &Vertex::getId() { return id; } // Return a reference to the vertex ID
 const size_t &Vertex::getId() const { return id; } // Return a const reference to the vertex ID
 
 // Add an edge to the vertex
-void Vertex::addEdge(Edge e) {
+void Vertex::addEdge(const Edge &e) {
     // Check if the edge is not already in the edges vector
     if (std::find(edges.begin(), edges.end(), e) == edges.end())
         edges.push_back(e); // Add the edge if it's not present
@@ -35,21 +35,21 @@ std::map<size_t, size_t>::iterator Vertex::adjEnd() {
 }
 
 // Check if the vertex has an edge connecting to a specific target vertex
-bool Vertex::hasEdge(Vertex target) const {
+bool Vertex::hasEdge(const Vertex &target) const {
     // Iterate through edges to check if any edge contains the target vertex
-    for (auto e : edges) {
-        if (e.contains(target))
+    for (const auto &e : edges) {
+        if (e.contains(target.getId()))
             return true; // Return true if an edge contains the target
     }
     return false; // Return false if no edge contains the target
 }
 
 // Remove an edge from the vertex
-void Vertex::removeEdge(Edge e) {
+void Vertex::removeEdge(const Edge &e) {
     // Remove the edge from the edges vector
     edges.erase(std::remove(edges.begin(), edges.end(), e), edges.end());
     // Remove the edge from the adjacency map using the other vertex
-    adj.erase(e.getOther(*this).getId());
+    adj.erase(e.getOther(id));
 }
 
 // Remove all edges from the vertex
@@ -58,6 +58,14 @@ void Vertex::removeAllEdges() {
     adj.clear();   // Clear the adjacency map
 }
 
+// Replace the edges of the vertex, used by bulk loading instead of one addEdge (and one linear search) per edge
+void Vertex::assignEdges(std::vector<Edge> list) {
+    edges = std::move(list);
+    adj.clear();
+    for (const auto &e : edges)
+        adj[e.getOther(id)] = e.getWeight(); // Neighbour and weight of every edge
+}
+
 // Get an iterator for the edges connected to the vertex
 std::vector<Edge>::iterator Vertex::begin() {
     return edges.begin(); // Return an iterator to the beginning of edges
@@ -74,10 +82,8 @@ bool Vertex::operator==(const Vertex &v) const {
 // Assignment operator to assign one vertex to another
 Vertex &Vertex::operator=(const Vertex &v) {
     id = v.id; // Assign the ID
-    // Copy edges from the source vertex
-    for (Edge e : v.edges) {
-        edges.push_back(e);
-    }
+    edges = v.edges; // Edges are plain ids, copy them as a flat vector
+    adj = v.adj; // Copy the adjacency map
     return *this; // Return the current vertex
 }
 
@@ -33,14 +33,17 @@ public:
     const size_t &getId() const;
 
     // Add an edge to the vertex
-    void addEdge(Edge e);
+    void addEdge(const Edge &e);
 
     // Remove an edge from the vertex
-    void removeEdge(Edge e);
+    void removeEdge(const Edge &e);
 
     //Remove all edges from the vertex
     void removeAllEdges();
 
+    // Replace the edges of the vertex with a list that has at most one edge per neighbour, the adjacency map follows
+    void assignEdges(std::vector<Edge> list);
+
     // Get an iterator for the edges connected to the vertex
     std::vector<Edge>::iterator begin();
     std::vector<Edge>::iterator end();
@@ -54,7 +57,7 @@ public:
     std::map<size_t,size_t>::iterator adjEnd();
 
     // Check if the vertex has an edge connecting to a specific target vertex
-    bool hasEdge(Vertex target) const;
+    bool hasEdge(const Vertex &target) const;
 
     bool operator==(const Vertex &other) const;
 
@@ -17,8 +17,13 @@
 #include "MST/MST_Factory.hpp"
 #include "LF/LeaderFollower.hpp"
 #include "ServerUtils/serverUtils.hpp"
+#include "ServerUtils/binaryProtocol.hpp"
+#include "ServerUtils/completionQueue.hpp"
+#include "DataStruct/workStealingPool.hpp"
 #include <signal.h>
 #include <atomic>
+#include <memory>
+#include <functional>
 #define PORT "8080"   
 #define SIZE 40
 
@@ -26,18 +31,17 @@ using namespace std;
 
 // global variable:
 LFP lf(4);             // Create an instance of LF
-map<int, Graph *> clients_graphs; // dictionary to store the client file descriptor and its graph
+map<int, shared_ptr<Graph>> clients_graphs; // dictionary to store the client file descriptor and its graph, shared with the MST jobs running on it
+map<int, ClientConn> clients_conns; // protocol state of every client connection
+SharedResultCache sharedResults;    // MST responses shared by the clients with the same graph
+CompletionQueue completions;        // MST jobs finished on the pool and responses ready to send, handed back to the poll loop
 struct pollfd *pfds;              // set of file descriptors (global to maintain correct memory management when interrupting the server)
 int fd_count = 0;
 
 //Signal handler to clean up resources when the server is stopped
 void handle_signal(int sig) {
     // Free allocated graphs for each client
-    for (auto &graph : clients_graphs) {
-        if (graph.second != nullptr) {
-            delete graph.second; // Delete graph if it exists
-            graph.second = nullptr;
-        } }
+    clients_graphs.clear();
     // Close all client connections
     for (int i = 0; i < fd_count; i++) {
         if (pfds[i].fd != -1) {
@@ -50,20 +54,13 @@ void handle_signal(int sig) {
 
 int main(void) {
     lf.start(); // Start the Leader-Follower threads
-    const vector<string> commands_graph = {"newgraph", "newedge", "removeedge", "mst"}; // Supported graph commands
-    const vector<string> mstStrats = {"prim", "kruskal"}; // Supported MST strategies
-
-    // Variable declarations for input handling
-    string action = "";
-    string current_act = "";
-    int n = 0; 
-    int m = 0;
-    int weight = 0;
-    string strat = "";
+    const vector<string> commands_graph = {"newgraph", "loadgraph", "newedge", "removeedge", "mst"}; // Supported graph commands
+    const vector<string> mstStrats = {"prim", "kruskal", "lazyprim", "denseprim", "auto", "boruvka", "tarjan", "filterkruskal"}; // Supported MST strategies
+
     int new_fd; // Newly accepted socket descriptor
     struct sockaddr_storage remote_address; // Client address structure
     socklen_t addr_len; // Length of client address
-    char buf[256] = {0}; // Buffer for client data
+    static char buf[64 * 1024] = {0}; // Buffer for client data, appended to the connection's input buffer
     char remoteIP[INET6_ADDRSTRLEN] = {0}; // Buffer for remote IP address
     // Initialize polling file descriptor array
     fd_count = 0; // Reset active file descriptor count
@@ -84,11 +81,98 @@ int main(void) {
     pfds[0].fd = listener; // Assign listener to the first position
     pfds[0].events = POLLIN; // Monitor for incoming connections
     fd_count = 1; // Count of active file descriptors (starting with listener)
+    // Watch for MST jobs finished on the pool as well
+    if (completions.fd() == -1) {
+        perror("eventfd");
+        exit(1);
+    }
+    add_to_pfds(&pfds, completions.fd(), &fd_count, &fd_size);
 
     signal(SIGINT, handle_signal); // Set signal handler for CTRL+C
 
+    // Store the result of a graph command for the client and broadcast it (or only log plain messages)
+    auto respond = [&](int sender_fd, const string &current_act, const pair<string, Graph *> &result) {
+        // If a new graph was created, store it in the clients_graphs map. The graph it replaces is freed once no MST job uses it
+        if (result.second != nullptr && result.second != clients_graphs[sender_fd].get()) {
+            clients_graphs[sender_fd].reset(result.second);
+        }
+        // Print the message to the server
+        if (current_act == "message") {
+            cout << result.first << endl; // Log the message
+            return; // Skip sending to other clients
+        }
+        // If the action is a graph command, broadcast the result to all clients, after the responses they wait for
+        if (find(commands_graph.begin(), commands_graph.end(), current_act) != commands_graph.end()) {
+            for (auto &client : clients_conns)
+                client.second.outbox->send(result.first.c_str(), result.first.size() + 1);
+        }
+    };
+
+    // Run the complete commands buffered for a client
+    function<void(int)> serve;
+    // Load a graph file on the pool, so the other clients are served meanwhile. The poll loop installs the graph,
+    // replies to the client alone and then runs the commands it sent after the loadgraph
+    auto load = [&](int sender_fd, const string &path) {
+        uint64_t conn_id = clients_conns[sender_fd].id;
+        shared_ptr<Outbox> out = clients_conns[sender_fd].outbox;
+        Outbox::Slot slot = out->reserve();
+        WorkStealingPool::global().submit([&serve, sender_fd, conn_id, out, slot, path]() {
+            pair<string, Graph *> result = loadGraph(path, sender_fd);
+            completions.post([&serve, sender_fd, conn_id, out, slot, result]() {
+                ClientConn *conn = liveConnection(clients_conns, sender_fd, conn_id);
+                if (conn == nullptr) {
+                    delete result.second; // The client left
+                    return;
+                }
+                if (result.second != nullptr)
+                    clients_graphs[sender_fd].reset(result.second); // The graph it replaces is freed once no MST job uses it
+                out->write(slot, result.first.c_str(), result.first.size() + 1);
+                out->done(slot);
+                conn->loading = false;
+                serve(sender_fd);
+            });
+        });
+    };
+    serve = [&](int sender_fd) {
+        ClientConn &conn = clients_conns[sender_fd];
+        if (!conn.binary) {
+            // Process the received text lines, a graph upload is read without blocking the other clients
+            processText(conn, sender_fd, commands_graph, mstStrats,
+                        [&](const string &act) { return graphFor(clients_graphs[sender_fd], act); },
+                        [&](const string &act, const pair<string, Graph *> &result) { respond(sender_fd, act, result); },
+                        [&](const string &path) { load(sender_fd, path); });
+        }
+        if (conn.binary) {
+            // Binary connection: run every complete frame
+            BinaryCommand cmd;
+            while (nextBinaryCommand(conn, cmd, mstStrats)) {
+                cout << "Binary act received: " << cmd.act << " from client: " << sender_fd << endl;
+                respond(sender_fd, cmd.act, handleBinary(graphFor(clients_graphs[sender_fd], cmd.act), cmd, sender_fd));
+            }
+        }
+    };
+
+    // Close a client's connection and forget it, a job still running on its graph keeps the graph
+    auto disconnect = [&](int i) {
+        int client_fd = pfds[i].fd;
+        close(client_fd); // Close the connection
+        del_from_pfds(pfds, i, &fd_count); // Remove the file descriptor from the pollfd array
+        clients_graphs.erase(client_fd); // Remove client from the dictionary
+        clients_conns.erase(client_fd); // Closes its outbox, responses still rendered for it are dropped
+    };
+
     // Main loop for handling client connections
     while (true) {
+        // Watch the clients with responses waiting in their outbox for room to send. A client whose graph is being
+        // loaded is not read from until it is, its next commands need that graph
+        for (int i = 0; i < fd_count; i++) {
+            auto conn = clients_conns.find(pfds[i].fd);
+            if (conn != clients_conns.end()) {
+                pfds[i].events = conn->second.loading ? 0 : POLLIN;
+                if (conn->second.outbox->wantsWrite())
+                    pfds[i].events |= POLLOUT;
+            }
+        }
         int poll_count = poll(pfds, (size_t)fd_count, -1); // Wait for an event on any file descriptor
         if (poll_count == -1) {
             perror("poll");
@@ -96,6 +180,20 @@ int main(void) {
         }
         // Iterate through active connections to check for data
         for (int i = 0; i < fd_count; i++) {
+            // Send the waiting responses the client's socket has room for
+            if (pfds[i].revents & POLLOUT) {
+                auto conn = clients_conns.find(pfds[i].fd);
+                if (conn != clients_conns.end() && !conn->second.outbox->flush(pfds[i].fd)) {
+                    disconnect(i);
+                    continue;
+                }
+            }
+            // A client that is not read from is only told apart as gone by the error
+            if ((pfds[i].revents & (POLLERR | POLLHUP)) && !(pfds[i].revents & POLLIN) && pfds[i].fd != listener) {
+                printf("LF: Client disconnected, socket %d\n", pfds[i].fd);
+                disconnect(i);
+                continue;
+            }
             // Check if a file descriptor is ready for reading
             if (pfds[i].revents & POLLIN) { // Data is ready to read
                 if (pfds[i].fd == listener) {
@@ -108,11 +206,13 @@ int main(void) {
                         add_to_pfds(&pfds, new_fd, &fd_count, &fd_size); // Add new client to the pollfd array
                         // Initialize the client's graph to null
                         clients_graphs[new_fd] = nullptr; 
+                        clients_conns[new_fd].id = nextConnectionId(); // Tells it apart from a later client on the same fd
+                        clients_conns[new_fd].outbox = make_shared<Outbox>(completions);
                         printf("LF: New connection\n");
-                        if (send(new_fd, start_messege, sizeof(start_messege), 0) < 0) {
-                            perror("send"); // Send welcome message to the new client
-                        }
+                        clients_conns[new_fd].outbox->send(start_messege, sizeof(start_messege)); // Send welcome message to the new client
                     }
+                } else if (pfds[i].fd == completions.fd()) {
+                    completions.run(); // Finish the MST jobs that are done
                 } else {
                     // Handle data from an existing connection
                     int num_of_bytes = recv(pfds[i].fd, buf, sizeof buf, 0); // Receive data from client
@@ -123,40 +223,11 @@ int main(void) {
                             printf("LF: Client disconnected, socket %d\n", sender_fd); 
                         else
                             perror("ERROR: receiving");
-
-                        close(pfds[i].fd); // Close the connection
-                        del_from_pfds(pfds, i, &fd_count); // Remove the file descriptor from the pollfd array
-                        if (clients_graphs[sender_fd] != nullptr) {
-                            // Delete the client's graph if it exists
-                            delete clients_graphs[sender_fd];
-                            clients_graphs[sender_fd] = nullptr; // Set to nullptr
-                        }
-                        clients_graphs.erase(sender_fd); // Remove client from the dictionary
+                        disconnect(i);
                     } else {
-                        // Process received message from the client
-                        parseInput(buf, num_of_bytes, n, m, weight, strat, action, current_act, commands_graph, mstStrats);
-                        cout << "Act received: " << action << " from client: " << sender_fd << endl;
-
-                        // Handle input and perform appropriate actions
-                        pair<string, Graph *> result = handleInput(clients_graphs[sender_fd], action, sender_fd, current_act, n, m, weight, strat);
-                        // If a new graph was created, store it in the clients_graphs map
-                        if (result.second != nullptr) {
-                            clients_graphs[sender_fd] = result.second;
-                        }
-                        // Print the message to the server
-                        if (current_act == "message") {
-                            cout << result.first << endl; // Log the message
-                            continue; // Skip sending to other clients
-                        }
-                        // If the action is a graph command, broadcast the result to all clients
-                        if (find(commands_graph.begin(), commands_graph.end(), current_act) != commands_graph.end()) {
-                            for (int j = 0; j < fd_count; j++) {
-                                int dest_fd = pfds[j].fd; // Destination file descriptor
-                                if (dest_fd != listener) // Ensure not to send to the listener
-                                    if (send(dest_fd, result.first.c_str(), result.first.size() + 1, 0) < 0) // Send message to clients
-                                        perror("send");
-                            }
-                        }
+                        // Buffer the bytes, commands and uploaded edges are handled once they are complete
+                        clients_conns[sender_fd].inbuf.append(buf, (size_t)num_of_bytes);
+                        serve(sender_fd);
                     }
                 }
             } 
@@ -168,17 +239,105 @@ int main(void) {
 
 /////////////////////////// More - Functions ///////////////////////
 
+// Render the statistics of result's MST into a slot of the client's outbox in bounded chunks, keeping a copy in result->text
+void renderMST(const shared_ptr<Outbox> &out, Outbox::Slot slot, const shared_ptr<CachedMST> &result) {
+    string msg = "Client request the MST\n";
+    msg += "MST statistics: \n";
+    auto sink = capturingSink(out, slot, result->text, result->complete, RESULT_CACHE_BUDGET);
+    if (sink(msg))
+        result->mst->streamStats(sink);
+}
+
+// Write a response rendered for another request to the slot, or render it again when it was not kept whole
+shared_ptr<const CachedMST> replayMST(const shared_ptr<Outbox> &out, Outbox::Slot slot, const shared_ptr<const CachedMST> &shared) {
+    if (shared->complete) {
+        out->write(slot, shared->text.data(), shared->text.size());
+        return shared;
+    }
+    shared_ptr<CachedMST> result = make_shared<CachedMST>();
+    result->mst = make_shared<Graph>(*shared->mst, true); // Own copy, the metrics are computed in place
+    renderMST(out, slot, result);
+    return result;
+}
+
 // Function to handle Minimum Spanning Tree (MST) requests
+// The response goes to a slot of the client's outbox reserved now, the poll loop sends it after the earlier responses
 pair<string, Graph *> MST(Graph *g, int client_fd, const string &strat) {
-    // Create the MST based on the provided strategy
-    Graph *mst = (*MST_Factory::getInstance()->createMST(strat))(g);
-    
-    // Add a task to the Leader-Follower instance for handling the MST response
-    lf.addTask([client_fd, strat, mst]() {
-        string msg = "Client request the MST\n";
-        msg += "MST statistics: \n" + mst->stats(); // Get statistics of the MST
-        send(client_fd, msg.c_str(), msg.size(), 0); // Send the response to the client
-        delete mst; // Free the MST graph after use
+    shared_ptr<ResultCache> results = clients_conns[client_fd].results; // This client's rendered responses
+    shared_ptr<Outbox> out = clients_conns[client_fd].outbox;
+    ResultKey version = versionKey(*g);
+    shared_ptr<const CachedMST> cached = results->get(version);
+    if (cached != nullptr) {
+        // The graph didn't change since this response was rendered, send it again
+        cout << "Client " << client_fd << " gets the cached MST response" << endl;
+        Outbox::Slot slot = out->reserve();
+        lf.addTask([out, slot, cached]() {
+            out->write(slot, cached->text.data(), cached->text.size());
+            out->done(slot);
+        });
+        return {"", nullptr};
+    }
+
+    // Another client may have the same graph
+    ResultKey content = contentKey(*g);
+    ResultClaim claim = sharedResults.claim(content, *g); // Only the same edges share a result, not just the same key
+    if (claim.result != nullptr) {
+        cout << "Client " << client_fd << " gets the MST response of an identical graph" << endl;
+        g->trackMST(*claim.result->mst); // Follow the edge updates from the tree the client is shown
+        results->put(version, claim.result);
+        cached = claim.result;
+        Outbox::Slot slot = out->reserve();
+        lf.addTask([out, slot, cached]() {
+            out->write(slot, cached->text.data(), cached->text.size());
+            out->done(slot);
+        });
+        return {"", nullptr};
+    }
+    Outbox::Slot slot = out->reserve();
+    if (!claim.owner) {
+        // An identical graph is being rendered for another client, answer when it is done without holding a thread
+        cout << "Client " << client_fd << " waits for the MST response of an identical graph" << endl;
+        claim.flight->onDone([out, slot, results, version](const shared_ptr<const CachedMST> &shared) {
+            lf.addTask([out, slot, results, version, shared]() {
+                results->put(version, replayMST(out, slot, shared));
+                out->done(slot);
+            });
+        });
+        return {"", nullptr};
+    }
+
+    // Reuse the MST kept up to date by newedge and removeedge since the last request, or compute it on the pool,
+    // so the clients' other commands are not held up meanwhile. The job runs on the snapshot the claim took, and
+    // shares the client's graph to tell whether it is still the one the tree belongs to (an edit goes to a copy,
+    // see graphFor)
+    MST_Strategy *algo = MST_Factory::getInstance()->createMST(strat); // Resolved here, throws on an unknown strategy
+    shared_ptr<CachedMST> result = make_shared<CachedMST>();
+    result->source = claim.flight->source(); // Snapshot of g taken by the claim, the next claims compare with it
+    result->mst.reset(g->trackedMST()); // Freed with the last response that uses it
+    shared_ptr<const Graph> snapshot;
+    if (result->mst == nullptr)
+        snapshot = clients_graphs[client_fd]; // g itself
+    shared_ptr<ResultFlight> flight = claim.flight;
+    uint64_t conn_id = clients_conns[client_fd].id;
+    WorkStealingPool::global().submit([client_fd, conn_id, out, slot, algo, result, snapshot, results, version, content, flight]() {
+        if (snapshot != nullptr)
+            result->mst.reset((*algo)(*result->source)); // Create the MST based on the provided strategy
+        // Rendered into the outbox, the job doesn't wait for the client. The clients waiting for the same graph are
+        // answered before the poll loop sends it
+        renderMST(out, slot, result);
+        results->put(version, result);
+        sharedResults.finish(content, flight, result);
+        out->done(slot);
+        if (snapshot == nullptr)
+            return;
+        completions.post([client_fd, conn_id, snapshot, result]() {
+            // Follow the edge updates from this tree, unless the client left, edited or replaced the graph meanwhile
+            if (liveConnection(clients_conns, client_fd, conn_id) == nullptr)
+                return;
+            auto it = clients_graphs.find(client_fd);
+            if (it != clients_graphs.end() && it->second == snapshot)
+                it->second->trackMST(*result->mst);
+        });
     });
     return {"", nullptr}; // No message needed for the main loop
-}
\ No newline at end of file
+}
@@ -7,7 +7,8 @@ using namespace std;
  * Each thread is assigned a unique ID and added to the `threads` vector.
  * @param num_threads The number of threads in the thread pool.
  */
-LFP::LFP(int num_threads) : stopFlag(false), leader(0) {  // Initialize stopFlag to false and leader to thread 0
+LFP::LFP(int num_threads) : ring(RING_CAPACITY), overflowCount(0), pending(0), leaderWaiting(false), hasLeader(false),
+                            stopFlag(false), leader(0) {  // The first thread to start becomes the leader
     for (int i = 0; i < num_threads; ++i) {
         // Create threads and assign worker function, passing thread ID
         threads.emplace_back(&LFP::worker, this, i);
@@ -25,16 +26,60 @@ LFP::~LFP() {
 
 /**
  * @brief Adds a new task to the task queue.
- * Tasks are represented as `std::function<void()>` objects, and the task
- * is added to the queue with thread-safety. One of the threads is notified 
- * to wake up and execute the task.
+ * Tasks are represented as `std::function<void()>` objects. The task goes into the ring without taking a lock,
+ * or into the overflow queue when the ring is full or older tasks are still waiting there. Only the leader is
+ * woken, and only when it is asleep.
  * @param task A function representing the task to be executed.
  */
 void LFP::addTask(function<void()> task) {
-    {
-        lock_guard<mutex> lock(queueMutex);  // Lock the queue mutex to ensure safe access
-        taskQueue.push(task);  // Add the task to the queue
-        condition.notify_one();  // Notify one waiting thread that a task is available
+    if (overflowCount.load(memory_order_acquire) != 0 || !ring.tryPush(task)) {
+        lock_guard<mutex> lock(overflowMutex);  // Rare: the ring is full
+        overflow.push(std::move(task));
+        overflowCount.fetch_add(1, memory_order_release);
+    }
+    // Both are sequentially consistent, as in nextTask: either the leader sees the task or this sees it asleep
+    pending.fetch_add(1);
+    if (leaderWaiting.load()) {
+        lock_guard<mutex> lock(leaderMutex);  // The leader is inside wait() once this is acquired
+        taskReady.notify_one();
+    }
+}
+
+/**
+ * @brief Take the oldest pending task without waiting.
+ * The ring is drained first, every task in the overflow queue was added after the ring's.
+ */
+bool LFP::takeTask(function<void()> &task) {
+    if (!ring.tryPop(task)) {
+        if (overflowCount.load(memory_order_acquire) == 0)
+            return false;
+        lock_guard<mutex> lock(overflowMutex);
+        if (overflow.empty())
+            return false;
+        task = std::move(overflow.front());
+        overflow.pop();
+        overflowCount.fetch_sub(1, memory_order_release);
+    }
+    pending.fetch_sub(1, memory_order_relaxed);
+    return true;
+}
+
+/**
+ * @brief Wait, as the leader, until a task is available.
+ * Pending tasks are still handed out once the pool is stopping, so everything added before stop() runs.
+ */
+bool LFP::nextTask(function<void()> &task) {
+    while (true) {
+        if (takeTask(task))
+            return true;
+        if (stopFlag.load())
+            return false;
+        unique_lock<mutex> lock(leaderMutex);
+        leaderWaiting.store(true);
+        // Check again, a task added before leaderWaiting was set did not notify
+        if (pending.load() == 0 && !stopFlag.load())
+            taskReady.wait(lock);
+        leaderWaiting.store(false);
     }
 }
 
@@ -43,10 +88,7 @@ void LFP::addTask(function<void()> task) {
  * Sets the stop flag to `false` so threads can begin working if they are not already.
  */
 void LFP::start() {
-    {
-        lock_guard<mutex> lock(stopMutex);  // Lock the stop mutex to safely change stopFlag
-        stopFlag = false;  // Ensure stopFlag is reset to false to allow threads to run
-    }
+    stopFlag = false;  // Ensure stopFlag is reset to false to allow threads to run
 }
 
 /**
@@ -54,15 +96,12 @@ void LFP::start() {
  * This sets the `stopFlag` to true, notifies all threads, and waits for each to finish.
  */
 void LFP::stop() {
+    stopFlag = true;  // Signal threads to stop after completing current tasks
+
+    // Wake the leader, it steps down on its way out and every follower in turn does the same
     {
-        lock_guard<mutex> lock(stopMutex);  // Lock the stop mutex
-        stopFlag = true;  // Signal threads to stop after completing current tasks
-    }
-    
-    // Notify all threads that they should wake up (either to finish tasks or terminate)
-    {
-        lock_guard<mutex> lock(queueMutex);  // Lock the queue mutex
-        condition.notify_all();  // Notify all threads
+        lock_guard<mutex> lock(leaderMutex);
+        taskReady.notify_all();
     }
 
     // Join all threads to ensure they have finished executing
@@ -75,44 +114,33 @@ void LFP::stop() {
 
 /**
  * @brief Worker function executed by each thread.
- * Threads continuously check for tasks in the queue and execute them if available.
- * They also handle the stop flag to exit when instructed to stop.
+ * The thread waits as a follower until it can take the leader role, waits as the leader until a task arrives,
+ * promotes a follower and runs the task. It exits when the pool is stopping and no task is left.
  * @param id The unique ID of the thread running this worker function.
  */
 void LFP::worker(int id) {
     while (true) {  // Continuously run unless stopped
-        function<void()> task;  // Placeholder for the task to be executed
-
-        // Lock the queue and wait for a task or stop signal
+        // Become the leader, right away if nobody holds the role
         {
-            unique_lock<mutex> lock(queueMutex);  // Lock the queue mutex
-            condition.wait(lock, [this]() {
-                lock_guard<mutex> stopLock(stopMutex);  // Lock stop mutex during check
-                return stopFlag || !taskQueue.empty();  // Continue if stopFlag is set or there are tasks
-            });
-
-            // Check if the stop flag is set and the task queue is empty, exit if true
-            {
-                lock_guard<mutex> stopLock(stopMutex);  // Lock the stop mutex
-                if (stopFlag && taskQueue.empty()) return;  // Exit worker loop
-            }
-
-            // If the current thread is the leader and there are tasks, pop a task from the queue
-            if (!taskQueue.empty() && this->leader == id) {
-                task = taskQueue.front();  // Get the task from the front of the queue
-                taskQueue.pop();  // Remove the task from the queue
-            } else {
-                continue;  // Continue if no task is assigned to this thread
-            }
+            unique_lock<mutex> lock(roleMutex);
+            promoted.wait(lock, [this]() { return !hasLeader; });
+            hasLeader = true;
+            leader = id;
         }
 
-        // Update the leader to the next thread (round-robin mechanism)
+        function<void()> task;  // Placeholder for the task to be executed
+        bool got = nextTask(task);
+
+        // Promote a follower before running the task, it waits for the next one meanwhile
         {
-            lock_guard<mutex> lock(queueMutex);  // Lock the queue mutex
-            leader = (size_t)(leader + 1) % threads.size();  // Cycle leader ID to next thread
+            lock_guard<mutex> lock(roleMutex);
+            hasLeader = false;
         }
+        promoted.notify_one();
+        if (!got)
+            return;  // Stopping, the promoted follower finds the queue empty and leaves as well
 
         // Execute the task outside of the lock
-        task();  
+        task();
     }
 }
@@ -7,12 +7,20 @@
 #include <condition_variable>
 #include <vector>
 #include <functional>
+#include <atomic>
+#include "../DataStruct/data_structures.hpp"
 
 using namespace std;
 
 /**
  * @brief Leader-Follower Pattern (LF) class manages a thread pool where
  * threads take turns becoming the leader and executing tasks from a queue.
+ *
+ * Exactly one thread, the leader, waits for tasks. When it gets one it promotes one follower to be the next leader
+ * and runs the task itself, so a task is never handed from one thread to another. Followers sleep until they are
+ * promoted, one at a time, and a thread that finishes its task while there is no leader takes the role back without
+ * sleeping. Tasks travel through a bounded lock-free ring; when it is full they wait in an overflow queue, which
+ * keeps addTask from blocking the caller.
  */
 class LFP {
 
@@ -51,13 +59,36 @@ class LFP {
          */
         void worker(int id);
 
+        /**
+         * @brief Wait, as the leader, until a task is available.
+         * @param task Set to the task.
+         * @return False when the pool is stopping and no task is left.
+         */
+        bool nextTask(function<void()> &task);
+
+        /**
+         * @brief Take the oldest pending task without waiting.
+         * @param task Set to the task.
+         * @return False when there is none.
+         */
+        bool takeTask(function<void()> &task);
+
+        static const size_t RING_CAPACITY = 1024; // Tasks the ring holds before addTask uses the overflow queue
+
         vector<thread> threads;             // Vector to store the pool of threads
         vector<int> threadIDs;              // Vector to store thread IDs
-        queue<function<void()>> taskQueue;  // Queue to store pending tasks
-        mutex queueMutex;                   // Mutex to protect access to the task queue
-        mutex stopMutex;                    // Mutex to protect the stop flag
-        condition_variable condition;       // Condition variable to notify threads of new tasks
-        bool stopFlag;                      // Flag to signal the termination of the thread pool
+        MPMCRing<function<void()>> ring;    // Pending tasks
+        queue<function<void()>> overflow;   // Tasks added while the ring was full, all newer than the ring's
+        mutex overflowMutex;                // Mutex to protect access to the overflow queue
+        atomic<size_t> overflowCount;       // Tasks in the overflow queue, read without the mutex
+        atomic<size_t> pending;             // Tasks added and not taken yet, counted after they are in a queue
+        mutex leaderMutex;                  // Mutex the leader sleeps on while there are no tasks
+        condition_variable taskReady;       // Wakes the leader when a task arrives, only the leader waits on it
+        atomic<bool> leaderWaiting;         // Set while the leader sleeps, addTask only notifies then
+        mutex roleMutex;                    // Mutex to protect the leader role
+        condition_variable promoted;        // Wakes one follower when the leader steps down
+        bool hasLeader;                     // Whether some thread holds the leader role
+        atomic<bool> stopFlag;              // Flag to signal the termination of the thread pool
         int leader;                         // ID of the leader thread (current leader)
 
 };
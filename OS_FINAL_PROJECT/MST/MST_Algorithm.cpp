@@ -1,82 +1,68 @@
 #include "MST_Algorithm.hpp"
 #include <limits>
+#include <tuple>
+#include <functional>
+#include <atomic>
+#include "../DataStruct/parallel.hpp"
+#include "../DataStruct/radixSort.hpp"
 
 
-// Comparator for priority queue (min-heap), compares based on the key values of vertices
-struct CompareVertex{
-    bool operator()(std::pair<size_t, int> const &value_1, std::pair<size_t, int> const &value_2){
-        return value_1.second < value_2.second; // Min-heap based on key values (second element of the pair)
-    }
-};
-
+// Arity of the heap used by Prim, 4 children per node keep a node's children in one cache line
+const size_t PRIM_HEAP_ARITY = 4;
 
 // Prim's algorithm implementation
-Graph* Prim::operator()(Graph *g) {
-    size_t V = g->numVertices(); // Number of vertices in the input graph
+Graph* Prim::run(const CSRGraph &g) {
+    size_t V = g.numVertices(); // Number of vertices in the input graph
+    const size_t NO_PARENT = static_cast<size_t>(-1);
 
     // Create a new graph for the Minimum Spanning Tree (MST) with the same vertices but no edges
-    Graph *mst = new Graph(*g, false);
-
-    const int INTINF = std::numeric_limits<int>::max(); // Define infinity value for initialization
+    Graph *mst = new Graph(V);
 
-    // Fibonacci min Heap to select the next vertex with the minimum key value
-    BinaryHeap<std::pair<size_t, int>, CompareVertex> minHeap;
+    // Indexed min heap of the vertices reached but not taken yet, keyed by the lightest edge into the tree
+    IndexedHeap<size_t, PRIM_HEAP_ARITY> minHeap(V);
 
     // Key values (weights) used to pick the minimum weight edge for each vertex
-    std::vector<int> key(V, INTINF);
+    std::vector<size_t> key(V, INF);
 
     // Array to store the parent of each vertex in the MST
-    std::vector<int> parent(V, -1);
+    std::vector<size_t> parent(V, NO_PARENT);
 
     // Boolean array to track vertices already included in the MST
     std::vector<bool> inMST(V, false);
 
-    // Start from the first vertex (arbitrarily chosen as 0)
-    size_t v_start = 0;
-    key[v_start] = 0; // Initialize the key value of the start vertex
-    for (auto v : *g) {
-        minHeap.push({v.first, key[(size_t)v.first]}); // Push all vertices into the priority queue
-    }
+    // Grow a tree from every vertex not reached yet, a disconnected graph gets a spanning forest
+    for (size_t root = 0; root < V; root++) {
+        if (inMST[root])
+            continue;
+        key[root] = 0; // Initialize the key value of the start vertex
+        minHeap.push(root, 0);
+
+        // Main loop of Prim's algorithm
+        while (!minHeap.empty()) {
+            size_t u = minHeap.pop(); // Extract the vertex with the minimum key value
+            inMST[u] = true; // Mark the vertex as included in the MST before relaxing, a self loop must not touch it
 
-    // Main loop of Prim's algorithm
-    while (!minHeap.empty()) {
-        // Extract the vertex with the minimum key value
-        auto minNode = minHeap.top();
-        minHeap.pop();
-        size_t u = minNode.first; // Vertex with minimum key value
-
-        // Iterate over all edges of the vertex u (Adj[u])
-        for (auto v = g->getVertex(u).adjBegin(); v != g->getVertex(u).adjEnd(); v++) {
-            size_t vertex = v->first; // Get the vertex v adjacent to u
-            int weight = v->second; // Get the weight of the edge (u, v)
-
-            // If v is not yet in MST and the weight of (u, v) is less than key[v]
-            if (!inMST[vertex] && weight < key[vertex]) {
-                size_t index = minHeap.getIndex({vertex, key[vertex]}); // Get index of vertex in the heap
-                key[vertex] = weight; // Update the key value of vertex v
-                minHeap.decreaseKey(index, {vertex, key[vertex]}); // Decrease the key value of the vertex in the priority queue
-                parent[vertex] = u; // Update parent[v]
+            // Iterate over all edges of the vertex u (Adj[u])
+            const size_t *w = g.weightsBegin(u);
+            for (const uint32_t *v = g.neighborsBegin(u); v != g.neighborsEnd(u); v++, w++) {
+                size_t vertex = *v; // Get the vertex v adjacent to u
+                // If v is not yet in MST and the weight of (u, v) is less than key[v]
+                if (!inMST[vertex] && *w < key[vertex]) {
+                    key[vertex] = *w; // Update the key value of vertex v
+                    minHeap.pushOrDecrease(vertex, *w); // O(1) lookup of v in the heap, no search
+                    parent[vertex] = u; // Update parent[v]
+                }
             }
         }
-        // Mark the vertex as included in the MST
-        inMST[u] = true;
     }
 
     // Adding all edges to the MST
     for (size_t i = 0; i < V; i++) {
-        if (parent[i] != -1) { // If parent[i] is valid
-            mst->addEdge(g->getVertex((size_t)parent[i]), g->getVertex(i), (size_t)key[i]); // Add edge to MST
+        if (parent[i] != NO_PARENT) { // If parent[i] is valid
+            mst->addEdge(Edge(parent[i], i, key[i])); // Add edge to MST
         }
     }
 
-    // Get the distance and parent matrices of the MST using Floyd-Warshall algorithm
-    std::vector<std::vector<size_t>> dist, per;
-    std::tie(dist, per) = mst->floydWarshall();
-    
-    // Update distance and parent matrices in mst
-    mst->setDistances(dist);
-    mst->setParent(per);
-
     return mst; // Return the constructed MST
 }
 
@@ -86,30 +72,451 @@ Graph* Prim::operator()(Graph *g) {
 
 
 
-    Graph* Kruskal::operator()(Graph *g){ 
-        Graph* mst = new Graph(*g, false); // Create a new graph with the same vertices as the input graph but no edges
+// Prim's algorithm on a Fibonacci heap (Fredman-Tarjan)
+Graph* Tarjan::run(const CSRGraph &g) {
+    size_t V = g.numVertices();
+    const size_t NO_PARENT = static_cast<size_t>(-1);
+    Graph *mst = new Graph(V);
+
+    FibonacciHeap<size_t> minHeap(V); // Vertices reached but not taken yet, keyed by the lightest edge into the tree
+    std::vector<size_t> key(V, INF);
+    std::vector<size_t> parent(V, NO_PARENT);
+    std::vector<bool> inMST(V, false);
+
+    // Grow a tree from every vertex not reached yet, a disconnected graph gets a spanning forest
+    for (size_t root = 0; root < V; root++) {
+        if (inMST[root])
+            continue;
+        key[root] = 0;
+        minHeap.push(root, 0);
+        while (!minHeap.empty()) {
+            size_t u = minHeap.pop();
+            inMST[u] = true; // Before relaxing, a self loop must not touch it
+            const size_t *w = g.weightsBegin(u);
+            for (const uint32_t *v = g.neighborsBegin(u); v != g.neighborsEnd(u); v++, w++) {
+                size_t vertex = *v;
+                if (!inMST[vertex] && *w < key[vertex]) {
+                    key[vertex] = *w;
+                    minHeap.pushOrDecrease(vertex, *w); // O(1) amortized, the point of the Fibonacci heap
+                    parent[vertex] = u;
+                }
+            }
+        }
+    }
+
+    for (size_t i = 0; i < V; i++) {
+        if (parent[i] != NO_PARENT)
+            mst->addEdge(Edge(parent[i], i, key[i]));
+    }
+    return mst;
+}
+
+
+
+////////////////////////////////////////////////////////////////////////////////////
+
+
+
+namespace {
+
+// Sort key of an edge for Kruskal
+struct KruskalKey {
+    size_t weight;
+    size_t index; // Position in the edge list
+};
+
+} // namespace
+
+    Graph* Kruskal::run(const CSRGraph &g){ 
+        Graph* mst = new Graph(g.numVertices()); // Create a new graph with the same vertices as the input graph but no edges
 
         std::vector<Edge> edges;  // Create a vector to store the edges
-        for (auto e = g->edgesBegin(); e != g->edgesEnd(); e++){
-            edges.push_back(*e);
+        edges.reserve(g.numEdges());
+        for (size_t u = 0; u < g.numVertices(); u++){
+            const size_t *w = g.weightsBegin(u);
+            for (const uint32_t *v = g.neighborsBegin(u); v != g.neighborsEnd(u); v++, w++){
+                if (u < *v) // Every undirected edge appears in both rows, take it once
+                    edges.push_back(Edge(u, *v, *w));
+            }
         }
-        std::sort(edges.begin(), edges.end());  // Sort the edges in non decreasing order of weight
+        // Sort (weight, index) keys in non decreasing order of weight. The integer sort is linear and stable, equal
+        // weights keep the edge order so the same graph always gives the same tree.
+        std::vector<KruskalKey> keys(edges.size());
+        for (size_t i = 0; i < edges.size(); i++)
+            keys[i] = KruskalKey{edges[i].getWeight(), i};
+        radixSort(keys, [](const KruskalKey &k) { return k.weight; });
 
-        UnionFind uf(g->numVertices());
+        UnionFind uf(g.numVertices());
+        size_t components = g.numVertices(); // Stop once everything is one tree
          /* for each edge E = u,v in G taken in non decreasing order of weight,
             if u and v are not in the same set, add E to the MST */
-        for (auto e : edges){
-            if (uf.find(e.getStart().getId()) != uf.find(e.getEnd().getId())){
+        for (size_t i = 0; i < keys.size() && components > 1; i++){
+            const Edge &e = edges[keys[i].index];
+            if (uf.Union(e.getStart(), e.getEnd())){ // False when u and v are already in the same set
                 mst->addEdge(e);
-                uf.Union(e.getStart().getId(), e.getEnd().getId());
+                components--;
             }
         }
-        std::vector<std::vector<size_t>> dist, parent;
-        // Get the distance and parent matrices of the MST
-        std::tie(dist, parent) = mst->floydWarshall();
-        //update distance and parent matrices in mst
-        mst->setDistances(dist);
-        mst->setParent(parent);
         return mst;
     }
 
+
+
+////////////////////////////////////////////////////////////////////////////////////
+
+
+
+// Lazy Prim's algorithm implementation
+Graph* LazyPrim::run(const CSRGraph &g) {
+    size_t V = g.numVertices();
+    Graph *mst = new Graph(V); // Same vertices, no edges
+
+    // Candidate edges (weight, vertex, parent), smallest weight on top. Ties go to the smaller vertex like Prim.
+    typedef std::tuple<size_t, size_t, size_t> Candidate;
+    std::priority_queue<Candidate, std::vector<Candidate>, std::greater<Candidate>> minHeap;
+    std::vector<bool> inMST(V, false);
+
+    // Grow a tree from every vertex not reached yet, a disconnected graph gets a spanning forest
+    for (size_t root = 0; root < V; root++) {
+        if (inMST[root])
+            continue;
+        minHeap.push(Candidate{0, root, root});
+        while (!minHeap.empty()) {
+            size_t weight = std::get<0>(minHeap.top()), u = std::get<1>(minHeap.top()), from = std::get<2>(minHeap.top());
+            minHeap.pop();
+            if (inMST[u])
+                continue; // Stale entry, u was reached through a lighter edge
+            inMST[u] = true;
+            if (u != root)
+                mst->addEdge(Edge(from, u, weight)); // Add edge to MST
+            const size_t *w = g.weightsBegin(u);
+            for (const uint32_t *v = g.neighborsBegin(u); v != g.neighborsEnd(u); v++, w++) {
+                if (!inMST[*v])
+                    minHeap.push(Candidate{*w, *v, u}); // Pushed even if a lighter entry is queued, skipped later
+            }
+        }
+    }
+    return mst;
+}
+
+
+
+////////////////////////////////////////////////////////////////////////////////////
+
+
+
+// Dense Prim's algorithm implementation
+Graph* DensePrim::run(const CSRGraph &g) {
+    size_t V = g.numVertices();
+    Graph *mst = new Graph(V); // Same vertices, no edges
+    const size_t NO_PARENT = static_cast<size_t>(-1);
+
+    // Vertices outside the tree, packed at the front of the arrays so every scan is one contiguous pass.
+    // remainingKey[i] is the lightest edge from the tree to remaining[i], slot[v] is the index of v.
+    std::vector<size_t> remaining(V), remainingKey(V, INF), slot(V), parent(V, NO_PARENT);
+    for (size_t v = 0; v < V; v++) {
+        remaining[v] = v;
+        slot[v] = v;
+    }
+
+    for (size_t left = V; left > 0; left--) {
+        // Scan for the closest vertex outside the tree, an unreached one starts a new tree of the forest
+        size_t best = 0;
+        for (size_t i = 1; i < left; i++) {
+            if (remainingKey[i] < remainingKey[best])
+                best = i;
+        }
+        size_t u = remaining[best], weight = remainingKey[best];
+        // Move the last remaining vertex into the hole
+        remaining[best] = remaining[left - 1];
+        remainingKey[best] = remainingKey[left - 1];
+        slot[remaining[best]] = best;
+        slot[u] = NO_PARENT; // u is in the tree now
+        if (parent[u] != NO_PARENT)
+            mst->addEdge(Edge(parent[u], u, weight)); // Add edge to MST
+        // Relax the edges of u
+        const size_t *w = g.weightsBegin(u);
+        for (const uint32_t *v = g.neighborsBegin(u); v != g.neighborsEnd(u); v++, w++) {
+            size_t i = slot[*v];
+            if (i != NO_PARENT && *w < remainingKey[i]) {
+                remainingKey[i] = *w;
+                parent[*v] = u;
+            }
+        }
+    }
+    return mst;
+}
+
+
+
+////////////////////////////////////////////////////////////////////////////////////
+
+
+
+// Boruvka's algorithm implementation
+Graph* Boruvka::run(const CSRGraph &g) {
+    const size_t V = g.numVertices();
+    Graph *mst = new Graph(V); // Same vertices, no edges
+    const uint64_t NONE = std::numeric_limits<uint64_t>::max(); // No edge picked
+
+    // Flat edge arrays, every undirected edge once
+    std::vector<uint32_t> from, to;
+    std::vector<size_t> weight;
+    from.reserve(g.numEdges());
+    to.reserve(g.numEdges());
+    weight.reserve(g.numEdges());
+    for (size_t u = 0; u < V; u++) {
+        const size_t *w = g.weightsBegin(u);
+        for (const uint32_t *v = g.neighborsBegin(u); v != g.neighborsEnd(u); v++, w++) {
+            if (u < *v) {
+                from.push_back(static_cast<uint32_t>(u));
+                to.push_back(*v);
+                weight.push_back(*w);
+            }
+        }
+    }
+    // Edges are ordered by (weight, index), a strict order so the picked edges can't close a cycle
+    auto lighter = [&weight](uint64_t a, uint64_t b) {
+        return b == NONE || weight[a] < weight[b] || (weight[a] == weight[b] && a < b);
+    };
+
+    std::vector<uint32_t> comp(V);   // Component of every vertex, the id of its root vertex
+    std::vector<uint32_t> roots(V);  // Ids of the current components
+    for (size_t v = 0; v < V; v++)
+        comp[v] = roots[v] = static_cast<uint32_t>(v);
+    ConcurrentUnionFind components(V);          // Merged components, its roots are the ids in roots
+    std::vector<std::atomic<uint64_t>> best(V); // Lightest outgoing edge of every component
+    std::vector<uint64_t> hooked(V, NONE);      // Edge a component was merged through, by position in roots
+    std::vector<size_t> alive(from.size());     // Edges between different components
+    for (size_t e = 0; e < alive.size(); e++)
+        alive[e] = e;
+    const size_t grain = 4096; // Edges, vertices or components per parallel task
+    auto tasks = [grain](size_t count) { return (count + grain - 1) / grain; };
+
+    while (!alive.empty()) {
+        const size_t numRoots = roots.size();
+        parallelFor(tasks(numRoots), [&](size_t t) {
+            for (size_t i = t * grain; i < std::min(numRoots, (t + 1) * grain); i++)
+                best[roots[i]].store(NONE, std::memory_order_relaxed);
+        });
+        // 1. Every component picks its lightest outgoing edge, the atomic min settles races between threads
+        parallelFor(tasks(alive.size()), [&](size_t t) {
+            for (size_t i = t * grain; i < std::min(alive.size(), (t + 1) * grain); i++) {
+                uint64_t e = alive[i];
+                for (uint32_t c : {comp[from[e]], comp[to[e]]}) {
+                    uint64_t current = best[c].load(std::memory_order_relaxed);
+                    while (lighter(e, current) && !best[c].compare_exchange_weak(current, e, std::memory_order_relaxed)) {}
+                }
+            }
+        });
+        // 2. Merge every component with the one at the other end of its edge. The picked edges form a forest
+        //    apart from two components picking the same edge, the second union of that pair finds them joined
+        //    already, so every edge is taken once.
+        parallelFor(tasks(numRoots), [&](size_t t) {
+            for (size_t i = t * grain; i < std::min(numRoots, (t + 1) * grain); i++) {
+                uint32_t c = roots[i];
+                uint64_t e = best[c].load(std::memory_order_relaxed);
+                hooked[i] = NONE;
+                if (e == NONE)
+                    continue; // No edge leaves the component
+                uint32_t other = comp[from[e]] == c ? comp[to[e]] : comp[from[e]];
+                if (components.Union(c, other))
+                    hooked[i] = e;
+            }
+        });
+        // 3. Contract: add the picked edges in component order and keep the components that are still roots
+        size_t numNewRoots = 0;
+        for (size_t i = 0; i < numRoots; i++) {
+            uint32_t c = roots[i];
+            if (hooked[i] != NONE)
+                mst->addEdge(Edge(from[hooked[i]], to[hooked[i]], weight[hooked[i]])); // Add edge to MST
+            if (components.find(c) == c)
+                roots[numNewRoots++] = c; // Still a root, ids stay in order
+        }
+        roots.resize(numNewRoots);
+        parallelFor(tasks(V), [&](size_t t) {
+            for (size_t v = t * grain; v < std::min(V, (t + 1) * grain); v++)
+                comp[v] = static_cast<uint32_t>(components.find(comp[v])); // No union runs now, find is exact
+        });
+        // 4. Drop the edges inside a component, each task compacts its own range
+        const size_t edgeTasks = tasks(alive.size());
+        std::vector<size_t> kept(edgeTasks, 0);
+        parallelFor(edgeTasks, [&](size_t t) {
+            size_t out = t * grain;
+            for (size_t i = t * grain; i < std::min(alive.size(), (t + 1) * grain); i++) {
+                if (comp[from[alive[i]]] != comp[to[alive[i]]])
+                    alive[out++] = alive[i];
+            }
+            kept[t] = out - t * grain;
+        });
+        size_t size = 0, before = alive.size();
+        for (size_t t = 0; t < edgeTasks; t++) {
+            std::copy(alive.begin() + static_cast<std::ptrdiff_t>(t * grain), alive.begin() + static_cast<std::ptrdiff_t>(t * grain + kept[t]), alive.begin() + static_cast<std::ptrdiff_t>(size));
+            size += kept[t];
+        }
+        alive.resize(size);
+        if (size == before)
+            break; // No edge joined two components, only possible if nothing is left to join
+    }
+    return mst;
+}
+
+
+
+////////////////////////////////////////////////////////////////////////////////////
+
+
+
+namespace {
+
+const size_t FILTER_KRUSKAL_MIN_SPLIT = 1 << 14; // Parts up to max(V, this) edges are sorted instead of split
+const size_t FILTER_KRUSKAL_SAMPLES = 63;        // Weights sampled to pick a pivot
+
+// Edge of the filter-Kruskal edge list, 16 bytes against the 24 of an Edge
+struct WeightedEdge {
+    size_t weight;
+    uint32_t u, v;
+};
+
+// State shared by the recursion
+struct FilterKruskalState {
+    UnionFind uf;
+    Graph *mst;
+    size_t components; // Stop once everything is one tree
+
+    FilterKruskalState(size_t V, Graph *mst) : uf(V), mst(mst), components(V) {}
+};
+
+// Stable parallel partition of in[0..count): the edges passing pred go to the front of out in input order, the rest
+// follow them if keepRest is set and are dropped otherwise. Returns how many passed.
+template <typename Pred>
+size_t partitionEdges(const WeightedEdge *in, size_t count, WeightedEdge *out, Pred pred, bool keepRest) {
+    const size_t numChunks = radixChunks(count);
+    auto chunkBegin = [&](size_t c) { return count * c / numChunks; };
+    std::vector<size_t> passed(numChunks + 1, 0);
+    parallelFor(numChunks, [&](size_t c) {
+        size_t n = 0;
+        for (size_t i = chunkBegin(c); i < chunkBegin(c + 1); i++)
+            if (pred(in[i]))
+                n++;
+        passed[c + 1] = n;
+    });
+    for (size_t c = 0; c < numChunks; c++)
+        passed[c + 1] += passed[c]; // Prefix sums, passed[c] is where chunk c starts writing
+    const size_t total = passed[numChunks];
+    parallelFor(numChunks, [&](size_t c) {
+        size_t front = passed[c], back = total + chunkBegin(c) - passed[c];
+        for (size_t i = chunkBegin(c); i < chunkBegin(c + 1); i++) {
+            if (pred(in[i]))
+                out[front++] = in[i];
+            else if (keepRest)
+                out[back++] = in[i];
+        }
+    });
+    return total;
+}
+
+// Plain Kruskal on a part small enough to sort
+void kruskalBase(WeightedEdge *edges, size_t count, FilterKruskalState &state) {
+    radixSort(edges, count, [](const WeightedEdge &e) { return e.weight; });
+    for (size_t i = 0; i < count && state.components > 1; i++) {
+        const WeightedEdge &e = edges[i];
+        if (state.uf.Union(e.u, e.v)) {
+            state.mst->addEdge(Edge(e.u, e.v, e.weight));
+            state.components--;
+        }
+    }
+}
+
+// Filter-Kruskal on edges[0..count), buffer is scratch space of the same size
+void filterKruskal(WeightedEdge *edges, WeightedEdge *buffer, size_t count, FilterKruskalState &state) {
+    if (count == 0 || state.components <= 1)
+        return;
+    if (count <= std::max(state.uf.size(), FILTER_KRUSKAL_MIN_SPLIT)) {
+        kruskalBase(edges, count, state);
+        return;
+    }
+    // Median of evenly spaced samples
+    std::vector<size_t> samples(FILTER_KRUSKAL_SAMPLES);
+    for (size_t s = 0; s < FILTER_KRUSKAL_SAMPLES; s++)
+        samples[s] = edges[count * s / FILTER_KRUSKAL_SAMPLES].weight;
+    std::nth_element(samples.begin(), samples.begin() + FILTER_KRUSKAL_SAMPLES / 2, samples.end());
+    const size_t pivot = samples[FILTER_KRUSKAL_SAMPLES / 2];
+
+    // Light edges to the front of buffer, heavy ones behind them. When the pivot is the largest weight everything
+    // is light, split below the pivot instead, and if that leaves nothing every weight is the same.
+    size_t light = partitionEdges(edges, count, buffer, [pivot](const WeightedEdge &e) { return e.weight <= pivot; }, true);
+    if (light == count) {
+        light = partitionEdges(edges, count, buffer, [pivot](const WeightedEdge &e) { return e.weight < pivot; }, true);
+        if (light == 0) {
+            kruskalBase(edges, count, state);
+            return;
+        }
+    }
+    filterKruskal(buffer, edges, light, state);
+
+    // Keep the heavy edges that still join two trees, the reads of the union find don't race with anything
+    const UnionFind &uf = state.uf;
+    size_t kept = partitionEdges(buffer + light, count - light, edges + light,
+                                 [&uf](const WeightedEdge &e) { return uf.root(e.u) != uf.root(e.v); }, false);
+    filterKruskal(edges + light, buffer + light, kept, state);
+}
+
+} // namespace
+
+// Filter-Kruskal implementation
+Graph* FilterKruskal::run(const CSRGraph &g) {
+    const size_t V = g.numVertices();
+    Graph *mst = new Graph(V); // Same vertices, no edges
+
+    // Every undirected edge once, the rows are split across the cores and written at their prefix offsets
+    const size_t numChunks = std::max<size_t>(1, std::min(parallelism() * 4, V / 1024));
+    auto chunkBegin = [&](size_t c) { return V * c / numChunks; };
+    std::vector<size_t> offset(numChunks + 1, 0);
+    parallelFor(numChunks, [&](size_t c) {
+        size_t n = 0;
+        for (size_t u = chunkBegin(c); u < chunkBegin(c + 1); u++)
+            for (const uint32_t *v = g.neighborsBegin(u); v != g.neighborsEnd(u); v++)
+                n += u < *v ? 1 : 0;
+        offset[c + 1] = n;
+    });
+    for (size_t c = 0; c < numChunks; c++)
+        offset[c + 1] += offset[c];
+    std::vector<WeightedEdge> edges(offset[numChunks]), buffer(offset[numChunks]);
+    parallelFor(numChunks, [&](size_t c) {
+        size_t i = offset[c];
+        for (size_t u = chunkBegin(c); u < chunkBegin(c + 1); u++) {
+            const size_t *w = g.weightsBegin(u);
+            for (const uint32_t *v = g.neighborsBegin(u); v != g.neighborsEnd(u); v++, w++)
+                if (u < *v) // Every undirected edge appears in both rows, take it once
+                    edges[i++] = WeightedEdge{*w, static_cast<uint32_t>(u), *v};
+        }
+    });
+
+    FilterKruskalState state(V, mst);
+    filterKruskal(edges.data(), buffer.data(), edges.size(), state);
+    return mst;
+}
+
+
+
+////////////////////////////////////////////////////////////////////////////////////
+
+
+
+// Name of the strategy that would run on g
+std::string AutoMST::choose(const CSRGraph &g) {
+    size_t V = g.numVertices(), E = g.numEdges();
+    if (V > 0 && E >= V * V / AUTO_DENSE_DIVISOR)
+        return "denseprim"; // O(V^2) no matter how many decrease-keys the weights cause
+    // Measured on random graphs from E = V up to E = V^2 / 4, the indexed heap beats both the lazy
+    // queue (fewer, smaller heap entries) and Kruskal (no sort of all the edges)
+    return "prim";
+}
+
+// Run the strategy picked for the density of g
+Graph* AutoMST::run(const CSRGraph &g) {
+    if (choose(g) == "denseprim")
+        return dense(g);
+    return prim(g);
+}
@@ -6,12 +6,74 @@
 
 
 class Prim : public MST_Strategy{
-public:
-    Graph* operator()(Graph *g);
+protected:
+    Graph* run(const CSRGraph &g) override;
+};
+
+
+// Prim on a Fibonacci heap, the Fredman-Tarjan bound: decrease-key is O(1) amortized, so the whole run is
+// O(E + V log V). Pays off on dense graphs, where most of the work is decrease-key rather than pop.
+class Tarjan : public MST_Strategy{
+protected:
+    Graph* run(const CSRGraph &g) override;
 };
 
 
 class Kruskal : public MST_Strategy{
+protected:
+    Graph* run(const CSRGraph &g) override;
+};
+
+
+// Prim without decrease-key: every relaxed edge is pushed to a plain std::priority_queue and stale entries are
+// skipped when popped. O(E log E) with simpler heap operations than the indexed heap.
+class LazyPrim : public MST_Strategy{
+protected:
+    Graph* run(const CSRGraph &g) override;
+};
+
+
+// Array based Prim: the next vertex is found by scanning the keys of the vertices outside the tree.
+// O(V^2 + E) whatever the weights, with no heap at all, which bounds the worst case once E is close to V^2.
+class DensePrim : public MST_Strategy{
+protected:
+    Graph* run(const CSRGraph &g) override;
+};
+
+
+// Parallel Boruvka: every round each component picks its lightest outgoing edge (atomic min per component),
+// the picked edges join the components and the labels are flattened, all spread across the cores.
+// O(E log V) work in at most log V rounds, the components at least halve every round.
+class Boruvka : public MST_Strategy{
+protected:
+    Graph* run(const CSRGraph &g) override;
+};
+
+
+// Filter-Kruskal: split the edges around a sampled pivot weight, solve the light part first, then drop every heavy
+// edge whose endpoints the light part already connected before going on with the rest. Partitions and filters run
+// across the cores and the small parts are sorted with the parallel radix sort, so on sparse graphs most heavy
+// edges are never sorted at all.
+class FilterKruskal : public MST_Strategy{
+protected:
+    Graph* run(const CSRGraph &g) override;
+};
+
+
+// The dense Prim is picked when E >= V^2 / AUTO_DENSE_DIVISOR, i.e. at least half of all vertex pairs are edges
+const size_t AUTO_DENSE_DIVISOR = 4;
+
+// Pick the implementation from the density of the graph, so clients don't have to guess.
+// Sparse graphs get the indexed-heap Prim too, it beat lazyprim, kruskal and filterkruskal down to E = 3V
+class AutoMST : public MST_Strategy{
 public:
-    Graph* operator()(Graph *g);
+    // Name of the strategy that would run on g: "prim" or "denseprim"
+    static std::string choose(const CSRGraph &g);
+
+protected:
+    Graph* run(const CSRGraph &g) override;
+
+private:
+    Prim prim;
+    DensePrim dense;
 };
@@ -7,7 +7,7 @@
 
 MST_Factory *MST_Factory::instance = nullptr;
 
-std::map<std::string, MST_Strategy *> MST_Factory::strats = {{"prim", nullptr}, {"kruskal", nullptr}, {"tarjan", nullptr}, {"boruvka", nullptr}};
+std::map<std::string, MST_Strategy *> MST_Factory::strats = {{"prim", nullptr}, {"kruskal", nullptr}, {"lazyprim", nullptr}, {"denseprim", nullptr}, {"auto", nullptr}, {"tarjan", nullptr}, {"boruvka", nullptr}, {"filterkruskal", nullptr}};
 std::mutex MST_Factory::instance_mutex;
 
 MST_Factory *MST_Factory::getInstance()
@@ -17,6 +17,12 @@ MST_Factory *MST_Factory::getInstance()
         instance = new MST_Factory();
         strats["prim"] = new Prim{};
         strats["kruskal"] = new Kruskal{};
+        strats["lazyprim"] = new LazyPrim{};
+        strats["denseprim"] = new DensePrim{};
+        strats["auto"] = new AutoMST{};
+        strats["boruvka"] = new Boruvka{};
+        strats["tarjan"] = new Tarjan{};
+        strats["filterkruskal"] = new FilterKruskal{};
         std::atexit(cleanUp);
     }
     return instance;
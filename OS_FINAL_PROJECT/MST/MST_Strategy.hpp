@@ -4,6 +4,11 @@
 class MST_Strategy
 {
 public:
-    virtual Graph* operator()(Graph *g) = 0;
+    // Build the MST of g, the strategy runs on an immutable CSR snapshot of the graph
+    Graph* operator()(Graph *g) { return run(g->snapshot()); }
+    Graph* operator()(const CSRGraph &g) { return run(g); }
     virtual ~MST_Strategy() = default;
-};
\ No newline at end of file
+
+protected:
+    virtual Graph* run(const CSRGraph &g) = 0;
+};
@@ -17,11 +17,16 @@
 #include <mutex>
 #include <signal.h>
 #include <vector>
+#include <deque>
 #include <functional>
 #include "Graph/graph.hpp"
 #include "MST/MST_Strategy.hpp"
 #include "MST/MST_Factory.hpp"
 #include "ServerUtils/serverUtils.hpp"
+#include "ServerUtils/binaryProtocol.hpp"
+#include "ServerUtils/completionQueue.hpp"
+#include "DataStruct/workStealingPool.hpp"
+#include "DataStruct/parallel.hpp"
 #include "Pipeline/pipelineActiveObject.hpp"
 
 #define PORT "8080"   // Port number where the server listens for connections
@@ -29,19 +34,38 @@
 
 using namespace std;
 
-// Struct to store the graph and the message to be sent to the client.
+// Struct to store the graph and the message to be sent to the client. One per MST request, freed by the last stage.
 struct Triple {
-    Graph* g;          // Pointer to the client's graph
+    Graph* g;          // Pointer to the MST, owned by result
     string msg;        // Message to be sent to the client
     int client_fd;     // File descriptor representing the client connection
+    string header;     // First line of the response, names the strategy and is not cached
+    ResultKey version{};                  // Version of the client's graph the MST belongs to
+    ResultKey content{};                  // Contents of the client's graph, for the cache shared by the clients
+    shared_ptr<const CachedMST> cached;   // Response rendered earlier for this graph, the stages only send it
+    shared_ptr<ResultFlight> flight;      // Rendering of an identical graph this response waits for, or is
+    shared_ptr<CachedMST> result;         // Response being rendered, stored in the caches when complete
+    shared_ptr<ResultCache> results;      // The client's cache
+    shared_ptr<Outbox> out;               // The client's outbox, the response is written to its slot
+    string weight, longest, average;      // Lines of the statistics stages, each written by its own stage
+    uint64_t conn_id = 0;                 // The client's connection, client_fd may belong to a later one by the time
+                                          // the request is queued
+    Outbox::Slot slot = 0;                // Reserved when the request was read, responses leave in request order
+
+    explicit Triple(int client_fd) : g(nullptr), client_fd(client_fd) {}
 };
 // Global variables
 int fd_count = 0;     // Counter for number of file descriptors (clients)
 Pipeline* pao = nullptr;   // Pointer to the Pipeline object managing tasks
-mutex mtx;            // Mutex for global synchronization
-map<int, pair<Graph*, Triple*>> clients_graphs;  // Maps client file descriptors to their graphs and associated Triple objects
-map<int, mutex> clients_mutex;  // Maps client file descriptors to their corresponding mutex for thread safety
+map<int, shared_ptr<Graph>> clients_graphs;  // Maps client file descriptors to their graphs, shared with the MST jobs running on them
+map<int, ClientConn> clients_conns;  // Protocol state of every client connection
+SharedResultCache sharedResults;     // MST responses shared by the clients with the same graph
+CompletionQueue completions;         // MST jobs finished on the pool and responses ready to send, handed back to the poll loop
 struct pollfd* pfds;  // Set of poll file descriptors, dynamically managed during client connections
+deque<Triple*> waitingTriples;  // Requests kept on the poll loop while the pipeline's first queue was full, in order
+map<int, size_t> clients_waiting;  // Number of kept requests of every client, a client with any is not read from,
+                                   // so it can't queue more meanwhile
+volatile sig_atomic_t metricsRequested = 0;  // Set by SIGUSR1, the poll loop prints the stage metrics
 
 
 /**
@@ -49,21 +73,11 @@ struct pollfd* pfds;  // Set of poll file descriptors, dynamically managed durin
  * Cleans up resources and safely shuts down the server by releasing allocated memory and closing client connections.
  */
 void handle_signal(int sig) {
-    for (auto& mtx : clients_mutex) {
-        mtx.second.lock();
-    }
-    // Clean up graphs and triples
-    for (auto& graph_triple : clients_graphs) {
-        if (graph_triple.second.first != nullptr) {  // Free the graph
-            delete graph_triple.second.first;}
-        if (graph_triple.second.second != nullptr) {  // Free the triple
-            if (graph_triple.second.second->g != nullptr) {  // Free the graph in the triple
-                delete graph_triple.second.second->g;
-                graph_triple.second.second->g = nullptr;}
-            delete graph_triple.second.second;  // Free the triple itself
-            graph_triple.second.second = nullptr;
-        }
+    if (pao != nullptr) {
+        cout << pao->report();  // What every stage did, to find the one to give more workers
     }
+    // Clean up graphs
+    clients_graphs.clear();
     // Clean up clients
     for (int i = 0; i < fd_count; i++) {
         if (pfds[i].fd != -1) {
@@ -74,59 +88,179 @@ void handle_signal(int sig) {
     if (pao != nullptr) {
         delete pao;  // Delete the Pipeline object
     }
-    for (auto& mtx : clients_mutex) {
-        mtx.second.unlock();
-    }
     exit(0);
 }
 
+/**
+ * Signal handler for SIGUSR1: asks the poll loop to print the stage metrics.
+ */
+void request_metrics(int) {
+    metricsRequested = 1;
+}
+
+/**
+ * Queues a request whose MST is known in the Pipeline.
+ * When the first stage's queue is full the request is kept, without blocking the poll loop, until flushWaiting.
+ * A request of a client that left meanwhile is dropped, unless it renders a response other requests wait for.
+ */
+void queueRequest(Triple* trip) {
+    bool live = liveConnection(clients_conns, trip->client_fd, trip->conn_id) != nullptr;
+    if (!live && trip->flight == nullptr) {
+        trip->out->done(trip->slot);
+        delete trip;
+        return;
+    }
+    if (waitingTriples.empty() && pao->tryAddTask(trip)) {
+        return;
+    }
+    waitingTriples.push_back(trip);  // Behind the requests kept before it
+    if (live) {
+        clients_waiting[trip->client_fd]++;  // Not read from until the request is queued
+    }
+}
+
+/**
+ * Queues the kept requests the Pipeline has room for, in order, and reads again from the clients with none left.
+ * Runs on the poll loop once the Pipeline reports room.
+ */
+void flushWaiting() {
+    while (!waitingTriples.empty()) {
+        // Read first, once queued the Triple belongs to the stages
+        int client_fd = waitingTriples.front()->client_fd;
+        bool live = liveConnection(clients_conns, client_fd, waitingTriples.front()->conn_id) != nullptr;
+        if (!pao->tryAddTask(waitingTriples.front())) {
+            return;  // Full again, the Pipeline reports the next room
+        }
+        waitingTriples.pop_front();
+        auto it = clients_waiting.find(client_fd);
+        if (live && it != clients_waiting.end() && --it->second == 0) {
+            clients_waiting.erase(it);  // Read from again
+        }
+    }
+}
+
+/**
+ * Renders the statistics the statistics stages add to a response, for a response that is rendered in one go.
+ * The shortest paths themselves are streamed after it.
+ */
+string renderStats(Graph* g) {
+    string msg = "Total weight of edges: " + std::to_string(g->totalWeight()) + "\n";
+    msg += g->longestPath() + "\n";
+    msg += "The average distance between vertices is: " + std::to_string(g->avgDistance()) + "\n";
+    msg += "The shortest paths are: \n";
+    return msg;
+}
+
 /**
  * Main function of the server.
  * Sets up the listener socket, manages client connections, and handles incoming messages to perform graph-related actions.
  */
-int main(void) {
-    // Create a list of functions to be executed by the Pipeline
-    std::vector<std::function<void(void*)>> functions = {
-        [](void* triple) { 
+int main(int argc, char* argv[]) {
+    // Create the stages to be executed by the Pipeline:
+    //
+    //              +-> total weight -----+
+    //   request ---+-> longest path -----+--> shortest paths, send --> cache
+    //              +-> average distance -+
+    //
+    // The three statistics run at once on the same Triple, each writes its own line. The shortest paths wait for
+    // all of them: they are streamed to the client's outbox, after the statistics, as they are found. Every response
+    // goes to the slot its request reserved, so the responses of a client leave in order whichever worker renders them
+    const size_t REQUEST = 0, WEIGHT = 1, LONGEST = 2, AVERAGE = 3, PATHS = 4;
+    std::vector<PipelineStage> stages = {
+        {[](void* triple) {
             Triple* t = (Triple*)triple;  // Cast the void* to Triple*
-            unique_lock<mutex> lock(clients_mutex[t->client_fd]);  // Lock the mutex
-            t->msg += "Total weight of edges: " + std::to_string((t->g)->totalWeight()) + "\n";
-        },
-        [](void* triple) {
+            if (t->result == nullptr) return;  // Rendered before or for an identical graph, the cache stage replays it
+            // The statistics only read the MST from here on, except for its connectivity which is found on first use
+            (t->g)->isConnected();
+        }},
+        {[](void* triple) {
             Triple* t = (Triple*)triple;
-            unique_lock<mutex> lock(clients_mutex[t->client_fd]);  
-            t->msg += (t->g)->longestPath() + "\n";
-        },
-        [](void* triple) {
+            if (t->result == nullptr) return;
+            t->weight = "Total weight of edges: " + std::to_string((t->g)->totalWeight()) + "\n";
+        }, 1, PIPELINE_QUEUE_CAPACITY, {REQUEST}},
+        {[](void* triple) {
             Triple* t = (Triple*)triple;
-            unique_lock<mutex> lock(clients_mutex[t->client_fd]);  
-            t->msg += "The average distance between vertices is: " + std::to_string((t->g)->avgDistance()) + "\n";
-        },
-        [](void* triple) {
+            if (t->result == nullptr) return;
+            t->longest = (t->g)->longestPath() + "\n";
+        }, 1, PIPELINE_QUEUE_CAPACITY, {REQUEST}},
+        {[](void* triple) {
             Triple* t = (Triple*)triple;
-            unique_lock<mutex> lock(clients_mutex[t->client_fd]);  
-            t->msg += "The shortest paths are: \n" + (t->g)->allShortestPaths() + "\n"; 
-        },
-        [](void* triple) {
+            if (t->result == nullptr) return;
+            t->average = "The average distance between vertices is: " + std::to_string((t->g)->avgDistance()) + "\n";
+        }, 1, PIPELINE_QUEUE_CAPACITY, {REQUEST}},
+        // The shortest paths are by far the slowest stage, it runs on one worker per hardware thread by default
+        {[](void* triple) {
             Triple* t = (Triple*)triple;
-            unique_lock<mutex> lock(clients_mutex[t->client_fd]);  
-            if (send(t->client_fd, t->msg.c_str(), t->msg.size(), 0) < 0)  // Send the message to the client
-                perror("send");
-        }
+            if (t->result == nullptr) return;
+            // The paths are streamed in bounded chunks, after what was gathered so far.
+            // Everything after the header is kept for the next request on the same graph version
+            t->msg = t->weight + t->longest + t->average + "The shortest paths are: \n";
+            auto sink = capturingSink(t->out, t->slot, t->result->text, t->result->complete, RESULT_CACHE_BUDGET);
+            if (t->out->write(t->slot, t->header.data(), t->header.size()) && sink(t->msg))
+                (t->g)->streamShortestPaths(sink);
+            else
+                t->result->complete = false;
+            t->msg = "\n";  // End of the message
+            sink(t->msg);
+            t->out->done(t->slot);
+        }, parallelism(), PIPELINE_QUEUE_CAPACITY, {WEIGHT, LONGEST, AVERAGE}},
+        {[](void* triple) {
+            Triple* t = (Triple*)triple;
+            unique_ptr<Triple> request(t);  // The request ends with this stage
+            if (t->result != nullptr) {  // Sent by the paths stage, keep it for the next requests on the graph
+                t->results->put(t->version, t->result);
+                if (t->flight != nullptr)  // Also answers the clients waiting for the same graph
+                    sharedResults.finish(t->content, t->flight, t->result);
+                return;
+            }
+            // Replay the response rendered earlier or for an identical graph.
+            // An identical graph was rendered before this request was queued
+            shared_ptr<const CachedMST> shared = t->cached;
+            if (!shared->complete) {
+                // Not kept whole, render it from the shared MST
+                t->result = make_shared<CachedMST>();
+                t->result->mst = make_shared<Graph>(*shared->mst, true);  // Own copy, the metrics are computed in place
+                t->g = t->result->mst.get();
+                t->msg = renderStats(t->g);
+                auto sink = capturingSink(t->out, t->slot, t->result->text, t->result->complete, RESULT_CACHE_BUDGET);
+                if (t->out->write(t->slot, t->header.data(), t->header.size()) && sink(t->msg))
+                    t->g->streamShortestPaths(sink);
+                t->msg = "\n";
+                sink(t->msg);
+                t->out->done(t->slot);
+                t->results->put(t->version, t->result);
+                return;
+            }
+            t->out->write(t->slot, t->header.data(), t->header.size());
+            t->out->write(t->slot, shared->text.data(), shared->text.size());
+            t->out->done(t->slot);
+            t->results->put(t->version, shared);
+        }, 1, PIPELINE_QUEUE_CAPACITY, {PATHS}}
     };
-    pao = new Pipeline(functions);  // Create a new Pipeline object with the functions
+    // Workers of each stage from the command line, e.g. ./pipeline-server 1,1,1,1,8,1
+    if (argc > 1) {
+        const char* list = argv[1];
+        for (size_t i = 0; i < stages.size() && *list != '\0'; i++) {
+            char* end = nullptr;
+            unsigned long workers = strtoul(list, &end, 10);
+            if (end == list || workers == 0) {
+                fprintf(stderr, "usage: %s [workers of each of the %zu stages, e.g. 1,1,1,1,4,1]\n", argv[0], stages.size());
+                exit(1);
+            }
+            stages[i].workers = workers;
+            list = *end == ',' ? end + 1 : end;
+        }
+    }
+    pao = new Pipeline(stages);  // Create a new Pipeline object with the stages
+    pao->onRoom([]() { completions.post(flushWaiting); });  // Queue the requests kept while the pipeline was full
     pao->start();  // Start the Pipeline object
-    const vector<string> graphActions = {"newgraph", "newedge", "removeedge", "mst"};
-    const vector<string> mstStrats = {"prim", "kruskal"};
-    string action = "";
-    string current_act = "";
-    int m = 0, n = 0, weight = 0;  // n := number of vertices, m := number of edges, weight := weight of the edge
-    string strat = "";  // Strategy for the MST
+    const vector<string> graphActions = {"newgraph", "loadgraph", "newedge", "removeedge", "mst"};
+    const vector<string> mstStrats = {"prim", "kruskal", "lazyprim", "denseprim", "auto", "boruvka", "tarjan", "filterkruskal"};
     char Msg[SIZE] = "Welcome to the Pipeline-server!\n";
     int new_fd;                          // Newly accepted socket descriptor
     struct sockaddr_storage remote_address; // Client address
     socklen_t addr_len;
-    char buf[256] = {0}; // Buffer for client data
+    static char buf[64 * 1024] = {0}; // Buffer for client data, appended to the connection's input buffer
     char remoteIP[INET6_ADDRSTRLEN] = {0};
     // Start off with room for 5 connections
     int fd_size = 5;
@@ -145,19 +279,131 @@ int main(void) {
     pfds[0].fd = listener;
     pfds[0].events = POLLIN; // Report ready to read on incoming connection
     fd_count = 1; // For the listener
+    // Watch for MST jobs finished on the pool as well
+    if (completions.fd() == -1) {
+        perror("eventfd");
+        exit(1);
+    }
+    add_to_pfds(&pfds, completions.fd(), &fd_count, &fd_size);
     cout << "Waiting for connections..." << endl;
 
     signal(SIGINT, handle_signal);  // Handle the CTRL+C signal
+    signal(SIGUSR1, request_metrics);  // kill -USR1 prints the metrics of every stage
+
+    // Store the result of a graph command for the client and send it to all the clients (or only log plain messages)
+    auto respond = [&](int sender_fd, const string &current_act, const pair<string, Graph*> &result) {
+        // If the result is a new graph, store it in the dictionary for this client. The graph it replaces is freed once no MST job uses it
+        if (result.second != nullptr && result.second != clients_graphs[sender_fd].get()) {
+            clients_graphs[sender_fd].reset(result.second);
+        }
+        // Print the message to the server
+        if (current_act == "message") {
+            cout << result.first << endl;
+            return;
+        }
+        // If the current_act is in the graphActions, then send the result to all the clients, after the responses
+        // they wait for
+        if (find(graphActions.begin(), graphActions.end(), current_act) != graphActions.end()) {
+            for (auto& client : clients_conns) {
+                client.second.outbox->send(result.first.c_str(), result.first.size() + 1);
+            }
+        }
+    };
+
+    // Run the complete commands buffered for a client
+    function<void(int)> serve;
+    // Load a graph file on the pool, so the other clients are served meanwhile. The poll loop installs the graph,
+    // replies to the client alone and then runs the commands it sent after the loadgraph
+    auto load = [&](int sender_fd, const string& path) {
+        uint64_t conn_id = clients_conns[sender_fd].id;
+        shared_ptr<Outbox> out = clients_conns[sender_fd].outbox;
+        Outbox::Slot slot = out->reserve();
+        WorkStealingPool::global().submit([&serve, sender_fd, conn_id, out, slot, path]() {
+            pair<string, Graph*> result = loadGraph(path, sender_fd);
+            completions.post([&serve, sender_fd, conn_id, out, slot, result]() {
+                ClientConn* conn = liveConnection(clients_conns, sender_fd, conn_id);
+                if (conn == nullptr) {
+                    delete result.second;  // The client left
+                    return;
+                }
+                if (result.second != nullptr) {
+                    clients_graphs[sender_fd].reset(result.second);  // The graph it replaces is freed once no MST job uses it
+                }
+                out->write(slot, result.first.c_str(), result.first.size() + 1);
+                out->done(slot);
+                conn->loading = false;
+                serve(sender_fd);
+            });
+        });
+    };
+    serve = [&](int sender_fd) {
+        ClientConn& conn = clients_conns[sender_fd];
+        if (!conn.binary) {
+            // Handling the text input, a graph upload is read without blocking the other clients
+            processText(conn, sender_fd, graphActions, mstStrats,
+                        [&](const string &act) { return graphFor(clients_graphs[sender_fd], act); },
+                        [&](const string &act, const pair<string, Graph*> &result) { respond(sender_fd, act, result); },
+                        [&](const string &path) { load(sender_fd, path); });
+        }
+        if (conn.binary) {
+            // Binary connection: run every complete frame
+            BinaryCommand cmd;
+            while (nextBinaryCommand(conn, cmd, mstStrats)) {
+                cout << "Binary action received: " << cmd.act << " from client " << sender_fd << endl;
+                respond(sender_fd, cmd.act, handleBinary(graphFor(clients_graphs[sender_fd], cmd.act), cmd, sender_fd));
+            }
+        }
+    };
+
+    // Close a client's connection and forget it, a job still running on its graph keeps the graph
+    auto disconnect = [&](int i) {
+        int client_fd = pfds[i].fd;
+        close(client_fd);  // Close the connection
+        del_from_pfds(pfds, i, &fd_count);  // Remove the connection from the set of connections
+        clients_graphs.erase(client_fd);  // Remove the client from the dictionary
+        clients_conns.erase(client_fd);  // Closes its outbox, responses still rendered for it are dropped
+        clients_waiting.erase(client_fd);  // Its kept requests no longer hold a later client on the fd
+    };
 
     // Main loop
     while (true) {
+        // Read from the clients without kept requests or a graph being loaded, and watch the ones with responses
+        // waiting for room to send
+        for (int i = 0; i < fd_count; i++) {
+            auto conn = clients_conns.find(pfds[i].fd);
+            if (conn != clients_conns.end()) {
+                pfds[i].events = clients_waiting.count(pfds[i].fd) || conn->second.loading ? 0 : POLLIN;
+                if (conn->second.outbox->wantsWrite()) {
+                    pfds[i].events |= POLLOUT;
+                }
+            }
+        }
         int poll_count = poll(pfds, (size_t)fd_count, -1);
+        if (metricsRequested) {
+            metricsRequested = 0;
+            cout << pao->report() << flush;
+        }
         if (poll_count == -1) {
+            if (errno == EINTR) continue;  // Interrupted by SIGUSR1
             perror("poll");
             exit(1);
         }
         // Run through the existing connections looking for data to read
         for (int i = 0; i < fd_count; i++) {
+            // Send the waiting responses the client's socket has room for
+            if (pfds[i].revents & POLLOUT) {
+                auto conn = clients_conns.find(pfds[i].fd);
+                if (conn != clients_conns.end() && !conn->second.outbox->flush(pfds[i].fd)) {
+                    disconnect(i);
+                    continue;
+                }
+            }
+            // A client that is not read from is only told apart as gone by the error
+            if ((pfds[i].revents & (POLLERR | POLLHUP)) && !(pfds[i].revents & POLLIN) && pfds[i].fd != listener) {
+                printf("pollserver: socket %d hung up\n", pfds[i].fd);
+                disconnect(i);
+                continue;
+            }
             // Check if someone's ready to read
             if (pfds[i].revents & POLLIN) {
                 if (pfds[i].fd == listener) { // If listener is ready to read, handle new connection
@@ -168,16 +414,18 @@ int main(void) {
                     } else {
                         add_to_pfds(&pfds, new_fd, &fd_count, &fd_size);
                         // Add the new client to the dictionary:
-                        clients_graphs[new_fd] = {nullptr, nullptr};  // Initialize both pointers to nullptr
+                        clients_graphs[new_fd] = nullptr;  // No graph yet
+                        clients_conns[new_fd].id = nextConnectionId();  // Tells it apart from a later client on the same fd
+                        clients_conns[new_fd].outbox = make_shared<Outbox>(completions);
                         printf("pollserver: new connection from %s on socket %d\n",
                                inet_ntop(remote_address.ss_family,
                                          getInAddr((struct sockaddr *)&remote_address),
                                          remoteIP, INET6_ADDRSTRLEN),
                                new_fd);
-                        if (send(new_fd, Msg, sizeof(Msg), 0) < 0) {
-                            perror("send");
-                        }
+                        clients_conns[new_fd].outbox->send(Msg, sizeof(Msg));
                     }
+                } else if (pfds[i].fd == completions.fd()) {
+                    completions.run();  // Queue the MST jobs that are done in the pipeline
                 } else { // Handle existing connection 
                     int nbytes = recv(pfds[i].fd, buf, sizeof buf, 0); // Receiving the msg from the client
                     int sender_fd = pfds[i].fd;
@@ -186,48 +434,11 @@ int main(void) {
                             printf("pollserver: socket %d hung up\n", sender_fd);
                         else
                             perror("ERROR: receiving data from client");
-                        close(pfds[i].fd);  // Close the connection 
-                        del_from_pfds(pfds, i, &fd_count);  // Remove the connection from the set of connections
-                        {
-                            unique_lock<mutex> lock(clients_mutex[sender_fd]);
-                            if (clients_graphs[sender_fd].first != nullptr) {  // If the client has a graph, delete it
-                                delete clients_graphs[sender_fd].first;
-                                clients_graphs[sender_fd].first = nullptr;
-                            }
-                            if (clients_graphs[sender_fd].second != nullptr) {  // If the client has a triple, delete it
-                                if (clients_graphs[sender_fd].second->g != nullptr) {  // If the triple has a graph, delete it
-                                    delete clients_graphs[sender_fd].second->g;
-                                    clients_graphs[sender_fd].second->g = nullptr;
-                                }
-                                delete clients_graphs[sender_fd].second;  // Delete the triple
-                                clients_graphs[sender_fd].second = nullptr;
-                            }
-                            clients_graphs.erase(sender_fd);  // Remove the client from the dictionary
-                        }
+                        disconnect(i);
                     } else {  // The client sent a message
-                        parseInput(buf, nbytes, n, m, weight, strat, action, current_act, graphActions, mstStrats);
-                        cout << "Action received: " << action << " from client " << sender_fd << endl;
-                        // Handling the input:
-                        pair<string, Graph*> result = handleInput(clients_graphs[sender_fd].first, action, sender_fd, current_act, n, m, weight, strat);
-                        if (result.second != nullptr) {  // If the result is not null, store it in the dictionary for this client
-                            clients_graphs[sender_fd].first = result.second;
-                        }
-                        // Print the message to the server
-                        if (current_act == "message") {
-                            cout << result.first << endl;
-                            continue;
-                        }
-                        // If the current_act is in the graphActions, then send the result to all the clients
-                        if (find(graphActions.begin(), graphActions.end(), current_act) != graphActions.end()) {
-                            for (int j = 0; j < fd_count; j++) {
-                                int dest_fd = pfds[j].fd;
-                                if (dest_fd != listener) {  // If the destination is not the listener
-                                    if (send(dest_fd, result.first.c_str(), result.first.size() + 1, 0) < 0) {  // Send the result to the client
-                                        perror("send");
-                                    }
-                                }
-                            }
-                        }
+                        // Buffer the bytes, commands and uploaded edges are handled once they are complete
+                        clients_conns[sender_fd].inbuf.append(buf, (size_t)nbytes);
+                        serve(sender_fd);
                     }
                 }
             } 
@@ -241,7 +452,8 @@ int main(void) {
 
 /**
  * Handles an MST request from a client.
- * This function creates a new Triple object for each request, assigns the task to the Pipeline, and processes the MST calculation.
+ * This function creates a new Triple object for the request and queues it in the Pipeline once its MST is known.
+ * A missing MST is computed by a job on the worker pool, the poll loop queues the Triple when the job is done.
  *
  * @param g The graph object pointer
  * @param client_fd The file descriptor for the client
@@ -249,28 +461,62 @@ int main(void) {
  * @return A pair consisting of the result message and the MST graph pointer
  */
 std::pair<std::string, Graph*> MST(Graph* g, int client_fd, const std::string& strat) {
-    Graph* graph_temp = nullptr;
-    Triple* trip = nullptr; {
-        unique_lock<mutex> lock(clients_mutex[client_fd]);  // Lock the mutex for thread safety
-        // Clean up any existing Triple or graph for the client
-        if (clients_graphs[client_fd].second != nullptr) {  
-            if (clients_graphs[client_fd].second->g != nullptr) {
-                delete clients_graphs[client_fd].second->g;  // Delete the old graph
-                clients_graphs[client_fd].second->g = nullptr;  }
-            delete clients_graphs[client_fd].second;  // Delete the old Triple
-        }
-        // Create a new Triple object and store it in the client's record
-        clients_graphs[client_fd].second = new Triple{g, strat, client_fd};  
-        trip = clients_graphs[client_fd].second;  // Assign the new Triple
-        // Select the MST algorithm strategy
-        MST_Strategy* MST_algo = MST_Factory::getInstance()->createMST(trip->msg);  
-        graph_temp = (*MST_algo)(trip->g);  // Generate the MST based on the selected strategy
-    }
-    // Update the Triple with the new MST graph and a success message
-    trip->g = graph_temp;  
-    trip->msg = "MST created using " + trip->msg + " strategy\n";
-    // Add the task to the Pipeline for further processing
-    pao->addTask(clients_graphs[client_fd].second);  
+    MST_Strategy* MST_algo = MST_Factory::getInstance()->createMST(strat);  // Select the MST algorithm strategy
+    Triple* trip = new Triple(client_fd);  // Freed by the last stage
+    trip->header = "MST created using " + strat + " strategy\n";
+    trip->results = clients_conns[client_fd].results;
+    trip->out = clients_conns[client_fd].outbox;
+    trip->slot = trip->out->reserve();  // The response leaves after the earlier ones, whichever is rendered first
+    trip->conn_id = clients_conns[client_fd].id;
+    trip->version = versionKey(*g);
+    trip->cached = trip->results->get(trip->version);  // The graph didn't change since the last response
     std::cout << "User " << client_fd << " requested to find MST of the Graph" << std::endl;
+    if (trip->cached != nullptr) {
+        queueRequest(trip);
+        return {"", nullptr};
+    }
+    // Another client may have the same graph
+    trip->content = contentKey(*g);
+    ResultClaim claim = sharedResults.claim(trip->content, *g);  // Only the same edges share a result, not just the same key
+    if (claim.result != nullptr) {
+        trip->cached = claim.result;
+        g->trackMST(*trip->cached->mst);  // Follow the edge updates from the tree the client is shown
+        queueRequest(trip);
+        return {"", nullptr};
+    }
+    if (!claim.owner) {
+        // An identical graph is being rendered for another request, queue this one when that request was sent
+        claim.flight->onDone([trip](const shared_ptr<const CachedMST>& shared) {
+            completions.post([trip, shared]() {
+                trip->cached = shared;
+                queueRequest(trip);
+            });
+        });
+        return {"", nullptr};
+    }
+    trip->flight = claim.flight;
+    trip->result = make_shared<CachedMST>();
+    trip->result->source = claim.flight->source();  // Snapshot of g taken by the claim, the next claims compare with it
+    trip->result->mst.reset(g->trackedMST());  // Kept up to date by newedge and removeedge since the last request
+    if (trip->result->mst != nullptr) {
+        trip->g = trip->result->mst.get();
+        queueRequest(trip);
+        return {"", nullptr};
+    }
+    // The job runs on the snapshot the claim took, and shares the client's graph to tell whether it is still the one
+    // the tree belongs to (an edit goes to a copy, see graphFor)
+    shared_ptr<const Graph> snapshot = clients_graphs[client_fd];  // g itself
+    WorkStealingPool::global().submit([trip, MST_algo, snapshot]() {
+        trip->result->mst.reset((*MST_algo)(*trip->result->source));  // Generate the MST based on the selected strategy
+        completions.post([trip, snapshot]() {
+            // Follow the edge updates from this tree, unless the client left, edited or replaced the graph meanwhile
+            auto it = clients_graphs.find(trip->client_fd);
+            if (liveConnection(clients_conns, trip->client_fd, trip->conn_id) != nullptr &&
+                it != clients_graphs.end() && it->second == snapshot)
+                it->second->trackMST(*trip->result->mst);
+            trip->g = trip->result->mst.get();
+            queueRequest(trip);
+        });
+    });
     return {"", nullptr};  // Return empty result since the processing will be done asynchronously
-}
\ No newline at end of file
+}
@@ -1,21 +1,55 @@
 #include "pipelineActiveObject.hpp"
+#include <algorithm>
+#include <stdexcept>
+#include <stdio.h>
+
+// One thread and a default queue per function
+static std::vector<PipelineStage> oneThreadEach(const std::vector<std::function<void(void*)>>& functions) {
+    std::vector<PipelineStage> stages;
+    for (const auto& func : functions) {
+        stages.emplace_back(func);
+    }
+    return stages;
+}
 
 /**
  * Constructor: Initializes a Pipeline object.
- * Takes a list of functions to be executed by the worker threads.
+ * Takes a list of functions to be executed by the worker threads, one thread and a default queue per function.
  */
-Pipeline::Pipeline(const std::vector<std::function<void(void*)>>& functions) : stopFlag(false) {
-    // Populate the workers vector with Worker structs
-    for (const auto& func : functions) {
-        // Creating a mutex and condition variable for each worker
+Pipeline::Pipeline(const std::vector<std::function<void(void*)>>& functions) : Pipeline(oneThreadEach(functions)) {}
+
+/**
+ * Constructor: Initializes a Pipeline object.
+ * Takes the stages with the number of threads running each, the capacity of the queue in front of each and the
+ * stages each comes after. A stage can only come after earlier stages, so the stages are in the order they run.
+ */
+Pipeline::Pipeline(const std::vector<PipelineStage>& stageList) : stopFlag(false), roomCallback(), started() {
+    // The stages each stage comes after, checked before anything is allocated
+    std::vector<std::vector<size_t>> after(stageList.size());
+    for (size_t i = 0; i < stageList.size(); ++i) {
+        after[i] = stageList[i].after;
+        if (after[i].empty() && i > 0) {
+            after[i].push_back(i - 1);  // A chain by default
+        }
+        std::sort(after[i].begin(), after[i].end());
+        after[i].erase(std::unique(after[i].begin(), after[i].end()), after[i].end());
+        if (!after[i].empty() && (i == 0 || after[i].back() >= i)) {
+            throw std::invalid_argument("Pipeline stage " + std::to_string(i) + " must come after earlier stages only");
+        }
+    }
+    for (size_t i = 0; i < stageList.size(); ++i) {
+        const PipelineStage& stage = stageList[i];
+        // Creating a mutex and condition variables for each stage
         std::mutex* taskQueueMutex = new std::mutex();
         std::condition_variable* taskCondition = new std::condition_variable();
-        // Add a new worker to the vector with the given function, empty task queue, mutex, and condition variable
-        workers.push_back({nullptr, func, std::queue<void*>(), taskQueueMutex, taskCondition, nullptr});
-    }
-    // Set the nextTaskQueue pointer for each worker, except the last one, to point to the next worker's task queue
-    for (size_t i = 0; i < workers.size() - 1; ++i) {
-        workers[i].nextTaskQueue = &workers[i + 1].taskQueue;
+        std::condition_variable* roomCondition = new std::condition_variable();
+        // Add a new stage to the vector with the given function, empty task queue, mutex, and condition variables
+        stages.push_back({stage.function, std::max<size_t>(1, stage.workers), std::max<size_t>(1, stage.capacity), {},
+                          std::queue<Entry>(), taskQueueMutex, taskCondition, roomCondition, false, after[i], {}, {},
+                          0, 0, 0, 0, 0, 0, 0});
+        for (size_t before : after[i]) {
+            stages[before].next.push_back(i);
+        }
     }
 }
 
@@ -25,87 +59,216 @@ Pipeline::Pipeline(const std::vector<std::function<void(void*)>>& functions) : s
 Pipeline::~Pipeline() {
     stop();  // Stop all worker threads
 
-    // Iterate over all workers and free associated resources (threads, mutexes, condition variables)
-    for (auto& worker : workers) {
-        if (worker.thread && worker.thread->joinable()) {
-            worker.thread->join();  // Ensure the thread has finished executing
+    // Iterate over all stages and free associated resources (threads, mutexes, condition variables)
+    for (auto& stage : stages) {
+        for (std::thread* thread : stage.threads) {
+            if (thread->joinable()) {
+                thread->join();  // Ensure the thread has finished executing
+            }
+            delete thread;
         }
-        // Free allocated memory for the thread, mutex, and condition variable
-        delete worker.thread;
-        delete worker.queueMutex;
-        delete worker.condition;
+        // Free allocated memory for the mutex and condition variables
+        delete stage.queueMutex;
+        delete stage.notEmpty;
+        delete stage.notFull;
     }
 }
 
 /**
- * Add a new task to the first worker's task queue.
- * This method locks the queue and notifies the first worker to start processing.
+ * Add a new task to the first stage's queue.
+ * Waits while the queue is full, so a producer faster than the pipeline is slowed down to its pace.
  */
 void Pipeline::addTask(void* newTask) {
-    std::lock_guard<std::mutex> lock(*(workers[0].queueMutex));
-    workers[0].taskQueue.push(newTask);
-    workers[0].condition->notify_one();  // Notify the first worker to start working on the new task
+    push(stages[0], newTask);
+}
+
+/**
+ * Add a new task to the first stage's queue if it has room.
+ * A full queue is remembered, the onRoom callback runs once a worker takes a task from it.
+ */
+bool Pipeline::tryAddTask(void* newTask) {
+    Stage& first = stages[0];
+    std::lock_guard<std::mutex> lock(*first.queueMutex);
+    if (first.taskQueue.size() >= first.capacity) {
+        first.rejected = true;
+        first.blocked++;
+        return false;
+    }
+    first.taskQueue.push({newTask, std::chrono::steady_clock::now()});
+    first.maxQueued = std::max(first.maxQueued, first.taskQueue.size());
+    first.notEmpty->notify_one();  // Notify a worker of the first stage to start working on the new task
+    return true;
+}
+
+/**
+ * Set the callback run when the first stage's queue has room again after tryAddTask found it full.
+ * Set it before start(), it runs on a worker thread.
+ */
+void Pipeline::onRoom(std::function<void()> callback) {
+    roomCallback = std::move(callback);
 }
 
 /**
  * Start all worker threads.
- * Iterates over all workers and creates threads for each, passing the workerFunction.
+ * Iterates over all stages and creates their threads, passing the workerFunction.
  */
 void Pipeline::start() {
     stopFlag = false;  // Reset the stop flag
+    started = std::chrono::steady_clock::now();
 
-    // Iterate over all workers and start a thread for each one
-    for (size_t i = 0; i < workers.size(); ++i) {
-        Worker* nextWorker = (i + 1 < workers.size()) ? &workers[i + 1] : nullptr;  // If it's not the last worker, set the next worker
-        workers[i].thread = new std::thread(&Pipeline::workerFunction, this, std::ref(workers[i]), nextWorker);
+    // Iterate over all stages and start their threads
+    for (auto& stage : stages) {
+        for (size_t w = 0; w < stage.numWorkers; ++w) {
+            stage.threads.push_back(new std::thread(&Pipeline::workerFunction, this, std::ref(stage)));
+        }
     }
 }
 
 /**
  * Stop all worker threads.
- * Sets the stop flag to true and notifies all workers to stop processing.
+ * Sets the stop flag to true and notifies all workers to stop processing, including those waiting for room.
  */
 void Pipeline::stop() {
     stopFlag = true;  // Signal the stop condition to all workers
 
-    // Notify all workers to stop by unlocking their mutex and signaling their condition variables
-    for (auto& worker : workers) {
-        std::lock_guard<std::mutex> lock(*worker.queueMutex);
-        worker.condition->notify_all();  // Notify all workers to exit
+    // Notify all workers to stop by locking their mutex and signaling their condition variables
+    for (auto& stage : stages) {
+        std::lock_guard<std::mutex> lock(*stage.queueMutex);
+        stage.notEmpty->notify_all();  // Notify all workers to exit
+        stage.notFull->notify_all();
+    }
+}
+
+/**
+ * Queue a task in front of a stage, waiting while its queue is full.
+ * The wait is the backpressure of a slow stage on the stage before it, and of the first stage on addTask.
+ */
+void Pipeline::push(Stage& stage, void* task) {
+    std::unique_lock<std::mutex> lock(*stage.queueMutex);
+    if (stage.taskQueue.size() >= stage.capacity) {
+        stage.blocked++;
+        // On stop the task is queued anyway, nothing would take it from a full queue
+        stage.notFull->wait(lock, [&]() { return stopFlag || stage.taskQueue.size() < stage.capacity; });
+    }
+    stage.taskQueue.push({task, std::chrono::steady_clock::now()});
+    stage.maxQueued = std::max(stage.maxQueued, stage.taskQueue.size());
+    stage.notEmpty->notify_one();  // Notify a worker of the stage to start working
+}
+
+/**
+ * Pass a finished task to the stages after stage.
+ * A stage after several stages counts which of them finished the task, the last one queues it.
+ */
+void Pipeline::forward(const Stage& stage, void* task) {
+    for (size_t index : stage.next) {
+        Stage& next = stages[index];
+        if (next.after.size() > 1) {
+            std::lock_guard<std::mutex> lock(*next.queueMutex);
+            size_t& arrived = next.arrivals[task];
+            if (++arrived < next.after.size()) {
+                continue;  // Other stages before it still run on the task
+            }
+            next.arrivals.erase(task);
+        }
+        push(next, task);
     }
 }
 
 /**
  * The worker function that continuously processes tasks until the stop flag is set.
- * Executes the assigned function on each task and forwards tasks to the next worker.
+ * Executes the stage's function on each task and forwards tasks to the next stages.
  */
-void Pipeline::workerFunction(Worker& currentWorker, Worker* nextWorker) {
+void Pipeline::workerFunction(Stage& stage) {
     while (!stopFlag) {
         // Task processing:
-        void* task = nullptr;
+        Entry entry;
+        bool room = false;  // The queue was full for tryAddTask and has room now
         {
-            std::unique_lock<std::mutex> lock(*currentWorker.queueMutex);
+            std::unique_lock<std::mutex> lock(*stage.queueMutex);
             // Wait until there's a task or the stop flag is set
-            currentWorker.condition->wait(lock, [&]() { return stopFlag || !currentWorker.taskQueue.empty(); });
+            stage.notEmpty->wait(lock, [&]() { return stopFlag || !stage.taskQueue.empty(); });
 
-            if (stopFlag && currentWorker.taskQueue.empty()) return;  // Exit if stop flag is set and no tasks remain
+            if (stopFlag && stage.taskQueue.empty()) return;  // Exit if stop flag is set and no tasks remain
 
-            task = currentWorker.taskQueue.front();  // Get the task from the queue
-            currentWorker.taskQueue.pop();  // Remove the task from the queue
+            entry = stage.taskQueue.front();  // Get the task from the queue
+            stage.taskQueue.pop();  // Remove the task from the queue
+            stage.busy++;
+            stage.waitMs += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - entry.queuedAt).count();
+            stage.notFull->notify_one();  // Room for a task waiting in push
+            room = stage.rejected;
+            stage.rejected = false;
         }
-
-        // Execute the worker's function with the task, if available
-        if (currentWorker.function) {
-            currentWorker.function(task);
+        if (room && roomCallback) {
+            roomCallback();
         }
 
-        // If there is a next worker, forward the task to their queue
-        if (nextWorker) {
-            std::lock_guard<std::mutex> lock(*nextWorker->queueMutex);
-            nextWorker->taskQueue.push(task);  // Forward the task to the next worker
-            nextWorker->condition->notify_one();  // Notify the next worker to start working
+        // Execute the stage's function with the task, if available
+        auto start = std::chrono::steady_clock::now();
+        if (stage.function) {
+            stage.function(entry.task);
+        }
+        double runMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        {
+            std::lock_guard<std::mutex> lock(*stage.queueMutex);
+            stage.busy--;
+            stage.processed++;
+            stage.runMs += runMs;
+            stage.maxRunMs = std::max(stage.maxRunMs, runMs);
         }
 
+        // Forward the task to the queues of the stages after this one, if there are any
+        forward(stage, entry.task);
+
         if (stopFlag) return;  // Check if stop flag was set mid-processing
     }
 }
+
+/**
+ * Get the metrics of every stage.
+ * Occupancy is the time the stage's workers spent in the function over the time they existed.
+ */
+std::vector<StageMetrics> Pipeline::metrics() const {
+    std::vector<StageMetrics> result;
+    double elapsedMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - started).count();
+    for (const auto& stage : stages) {
+        std::lock_guard<std::mutex> lock(*stage.queueMutex);
+        StageMetrics m;
+        m.workers = stage.numWorkers;
+        m.capacity = stage.capacity;
+        m.queued = stage.taskQueue.size();
+        m.busy = stage.busy;
+        m.processed = stage.processed;
+        m.maxQueued = stage.maxQueued;
+        m.blocked = stage.blocked;
+        m.joining = stage.arrivals.size();
+        m.avgWaitMs = stage.processed == 0 ? 0 : stage.waitMs / static_cast<double>(stage.processed);
+        m.avgRunMs = stage.processed == 0 ? 0 : stage.runMs / static_cast<double>(stage.processed);
+        m.maxRunMs = stage.maxRunMs;
+        m.occupancy = elapsedMs <= 0 ? 0 : stage.runMs / (elapsedMs * static_cast<double>(stage.numWorkers));
+        result.push_back(m);
+    }
+    return result;
+}
+
+/**
+ * Format the metrics as a table, one line per stage.
+ * Stages are numbered from 1, the last column lists the stages each comes after.
+ */
+std::string Pipeline::report() const {
+    std::string out = "stage workers  queued/cap  busy  processed  max queued  blocked  joining  avg wait ms  avg run ms  max run ms  occupancy  after\n";
+    std::vector<StageMetrics> all = metrics();
+    for (size_t i = 0; i < all.size(); i++) {
+        const StageMetrics& m = all[i];
+        char line[256];
+        snprintf(line, sizeof line, "%5zu %7zu %7zu/%-4zu %4zu %10zu %11zu %8zu %8zu %12.3f %11.3f %11.3f %9.1f%%  ",
+                 i + 1, m.workers, m.queued, m.capacity, m.busy, m.processed, m.maxQueued, m.blocked, m.joining,
+                 m.avgWaitMs, m.avgRunMs, m.maxRunMs, m.occupancy * 100);
+        out += line;
+        std::string after;
+        for (size_t before : stages[i].after) {
+            after += (after.empty() ? "" : ",") + std::to_string(before + 1);
+        }
+        out += (after.empty() ? "-" : after) + "\n";
+    }
+    return out;
+}
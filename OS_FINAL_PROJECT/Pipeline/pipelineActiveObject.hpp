@@ -6,46 +6,126 @@
 #include <condition_variable>
 #include <functional>
 #include <atomic>
+#include <chrono>
 #include <string>
 #include <utility>
+#include <unordered_map>
 #include "../ServerUtils/serverUtils.hpp"
 #include "../Graph/graph.hpp"
 
+const size_t PIPELINE_QUEUE_CAPACITY = 64;  // Default number of tasks that may wait in front of a stage
 
+// One stage of a pipeline: the function run on every task, how many threads run it, how many tasks may wait for it,
+// and the stages that have to finish a task before it runs
+struct PipelineStage {
+    std::function<void(void*)> function;
+    size_t workers;
+    size_t capacity;
+    std::vector<size_t> after;  // Indices of earlier stages, empty for the stage just before (none for the first)
+
+    PipelineStage(std::function<void(void*)> function, size_t workers = 1, size_t capacity = PIPELINE_QUEUE_CAPACITY,
+                  std::vector<size_t> after = {})
+        : function(std::move(function)), workers(workers), capacity(capacity), after(std::move(after)) {}
+};
+
+// Metrics of one stage since the pipeline started
+struct StageMetrics {
+    size_t workers;
+    size_t capacity;
+    size_t queued;         // Tasks waiting in front of the stage now
+    size_t busy;           // Workers running the function now
+    size_t processed;      // Tasks the stage finished
+    size_t maxQueued;      // Most tasks that waited at once
+    size_t blocked;        // Times a task had to wait for room in the stage's queue
+    size_t joining;        // Tasks some but not all of the stages before it finished
+    double avgWaitMs;      // Average time a task waited in the queue
+    double avgRunMs;       // Average time the function took
+    double maxRunMs;
+    double occupancy;      // Share of the workers' time spent running the function
+};
+
+/*
+ * Pipeline of stages forming a DAG.
+ *
+ * Tasks enter at the first stage. A stage passes a finished task to every stage listed after it, so the stages
+ * after the same stage run on the same task at once, and a stage after several stages runs once all of them
+ * finished the task. The functions of stages that may run at once must touch different parts of the task, and
+ * a task is only done once every stage ran on it: free it in a stage every other stage leads to.
+ * Tasks are told apart by their pointer at the joins, the same pointer must not be queued again before it is done.
+ */
 class Pipeline {
 public:
-    // Constructor: Accepts a list of functions to be executed by worker threads
+    // Constructor: Accepts a list of functions to be executed by worker threads, one thread per function
     Pipeline(const std::vector<std::function<void(void*)>>& functions);
 
+    // Constructor: Accepts the stages with their number of threads, queue capacity and the stages they come after.
+    // Throws std::invalid_argument when a stage comes after itself or a later stage
+    Pipeline(const std::vector<PipelineStage>& stages);
+
     // Destructor: Cleans up resources and ensures threads are stopped
     ~Pipeline();
-    
+
     // Default constructor (in case we need it)
     Pipeline() = default;
 
-    // Adds a task to be executed by the workers
+    // Adds a task to be executed by the workers, waits while the first stage's queue is full
     void addTask(void* task);
-    
+
+    // Adds a task unless the first stage's queue is full, returns whether it was added
+    bool tryAddTask(void* task);
+
+    // Sets a callback run by a worker when the first stage's queue has room again after tryAddTask found it full
+    void onRoom(std::function<void()> callback);
+
     // Starts the worker threads and begins processing tasks
     void start();
 
     // Signals the workers to stop processing and shuts down the threads
     void stop();
 
+    // Gets the metrics of every stage, in pipeline order
+    std::vector<StageMetrics> metrics() const;
+
+    // Formats the metrics as a table, one line per stage with the stages it comes after
+    std::string report() const;
+
 private:
-    // Worker struct: Represents an individual worker thread and its associated data
-    struct Worker {
-        std::thread* thread;  // Pointer to the thread running the worker
-        std::function<void(void*)> function;  // Function that the worker will execute on tasks
-        std::queue<void*> taskQueue;  // Queue of tasks assigned to the worker (tasks are of generic type `void*`)
-        std::mutex* queueMutex;  // Mutex for synchronizing access to the worker's task queue
-        std::condition_variable* condition;  // Condition variable to notify the worker of new tasks
-        std::queue<void*>* nextTaskQueue;  // Pointer to the task queue of the next worker in the pipeline
+    // A queued task and when it was queued
+    struct Entry {
+        void* task;
+        std::chrono::steady_clock::time_point queuedAt;
     };
 
-    // Function that defines the behavior of a worker thread. Processes tasks and passes them to the next worker.
-    void workerFunction(Worker& worker, Worker* nextWorker);
+    // Stage struct: the threads running one function and the bounded queue in front of them
+    struct Stage {
+        std::function<void(void*)> function;  // Function that the workers will execute on tasks
+        size_t numWorkers;                    // Threads running the function
+        size_t capacity;                      // Most tasks the queue holds, a full queue blocks the previous stage
+        std::vector<std::thread*> threads;    // Pointers to the threads running the workers
+        std::queue<Entry> taskQueue;          // Queue of tasks assigned to the stage (tasks are of generic type `void*`)
+        std::mutex* queueMutex;               // Mutex for the queue and the metrics below
+        std::condition_variable* notEmpty;    // Notifies the workers of new tasks
+        std::condition_variable* notFull;     // Notifies the previous stage of room in the queue
+        bool rejected;                        // tryAddTask found the queue full since the last onRoom callback
+        std::vector<size_t> after;            // Stages that finish a task before this one runs on it
+        std::vector<size_t> next;             // Stages this one passes its finished tasks to
+        std::unordered_map<void*, size_t> arrivals;  // Stages before it that finished each task, while some didn't
+        // Metrics
+        size_t busy, processed, maxQueued, blocked;
+        double waitMs, runMs, maxRunMs;
+    };
+
+    // Function that defines the behavior of a worker thread. Processes tasks and passes them to the next stages.
+    void workerFunction(Stage& stage);
+
+    // Pass a finished task to the stages after stage, a stage after several once the last of them finished it
+    void forward(const Stage& stage, void* task);
+
+    // Queue a task in front of stage, waiting for room while the queue is full
+    void push(Stage& stage, void* task);
 
-    std::vector<Worker> workers;  // Vector holding all worker threads
+    std::vector<Stage> stages;    // Vector holding all stages
     std::atomic<bool> stopFlag;   // Atomic flag used to signal workers to stop
+    std::function<void()> roomCallback;
+    std::chrono::steady_clock::time_point started;
 };
@@ -0,0 +1,155 @@
+#include "binaryProtocol.hpp"
+#include "serverUtils.hpp"
+#include <climits>
+#include <cstring>
+
+// Read a little-endian 32-bit value from an unaligned buffer
+uint32_t readLE32(const char *p){
+    const unsigned char *b = reinterpret_cast<const unsigned char *>(p);
+    return static_cast<uint32_t>(b[0]) | (static_cast<uint32_t>(b[1]) << 8) | (static_cast<uint32_t>(b[2]) << 16) | (static_cast<uint32_t>(b[3]) << 24);
+}
+
+// If line is the negotiation command, switch conn to binary framing and reply to the client
+bool negotiateBinary(ClientConn &conn, const std::string &line){
+    std::vector<std::string> command = split_spaces(lower_case(line));
+    if (command.size() != 1 || command[0] != "binary")
+        return false; // A regular text command
+    conn.binary = true;
+    std::string msg = "Binary protocol enabled\n";
+    conn.outbox->send(msg.c_str(), msg.size()); // After the responses still rendered for the text commands
+    return true;
+}
+
+// Decode the next complete frame buffered on conn
+bool nextBinaryCommand(ClientConn &conn, BinaryCommand &cmd, const std::vector<std::string> &mstStrats){
+    // Drop the frames handled by the previous calls
+    if (conn.consumed > 0){
+        conn.inbuf.erase(0, conn.consumed);
+        conn.consumed = 0;
+    }
+    if (conn.inbuf.size() < BINARY_HEADER_SIZE)
+        return false; // Length prefix not complete yet
+    uint32_t length = readLE32(conn.inbuf.data());
+    if (length == 0 || length > BINARY_MAX_FRAME){
+        // The stream can't be resynchronised after a bad length, drop what was buffered
+        cmd = BinaryCommand();
+        cmd.act = "message";
+        cmd.error = "Invalid binary frame length " + std::to_string(length) + "\n";
+        conn.inbuf.clear();
+        conn.outbox->send(cmd.error.c_str(), cmd.error.size() + 1);
+        return true;
+    }
+    if (conn.inbuf.size() < BINARY_HEADER_SIZE + length)
+        return false; // Frame not complete yet
+    conn.consumed = BINARY_HEADER_SIZE + length;
+
+    const char *frame = conn.inbuf.data() + BINARY_HEADER_SIZE;
+    uint8_t op = static_cast<uint8_t>(frame[0]);
+    const char *payload = frame + 1;
+    size_t size = length - 1; // Payload size
+    cmd = BinaryCommand();
+    cmd.act = "message";
+
+    switch (op){
+        case OP_NEWGRAPH: {
+            if (size < 8){
+                cmd.error = "Invalid newgraph frame\n";
+                break;
+            }
+            uint32_t n = readLE32(payload), m = readLE32(payload + 4);
+            if (n == 0 || n > INT_MAX || m > INT_MAX || size != 8 + static_cast<size_t>(m) * BINARY_RECORD_SIZE){
+                cmd.error = "Invalid newgraph frame\n";
+                break;
+            }
+            // Bound the vertices by the edges that came with them, as loadgraph does, before anything is allocated
+            if (n > 2 * static_cast<size_t>(m) + 1){
+                cmd.error = "Invalid newgraph frame, " + std::to_string(m) + " edges can't reach " + std::to_string(n) + " vertices\n";
+                break;
+            }
+            // Weights are checked as for newedge, vertices outside the graph are skipped by newGraph
+            bool weightsValid = true;
+            for (uint32_t i = 0; i < m && weightsValid; i++)
+                weightsValid = readLE32(payload + 8 + i * BINARY_RECORD_SIZE + 8) <= INT_MAX;
+            if (!weightsValid){
+                cmd.error = "Invalid newgraph frame\n";
+                break;
+            }
+            cmd.act = "newgraph";
+            cmd.n = static_cast<int>(n);
+            cmd.m = static_cast<int>(m);
+            cmd.records = payload + 8; // Parsed in place by newGraph
+            break;
+        }
+        case OP_NEWEDGE: {
+            if (size != 12){
+                cmd.error = "Invalid newedge frame\n";
+                break;
+            }
+            uint32_t u = readLE32(payload), v = readLE32(payload + 4), w = readLE32(payload + 8);
+            if (u == 0 || v == 0 || u > INT_MAX || v > INT_MAX || w > INT_MAX){
+                cmd.error = "Invalid newedge frame\n";
+                break;
+            }
+            cmd.act = "newedge";
+            cmd.n = static_cast<int>(u);
+            cmd.m = static_cast<int>(v);
+            cmd.weight = static_cast<int>(w);
+            break;
+        }
+        case OP_REMOVEEDGE: {
+            if (size != 8){
+                cmd.error = "Invalid removeedge frame\n";
+                break;
+            }
+            uint32_t u = readLE32(payload), v = readLE32(payload + 4);
+            if (u == 0 || v == 0 || u > INT_MAX || v > INT_MAX){
+                cmd.error = "Invalid removeedge frame\n";
+                break;
+            }
+            cmd.act = "removeedge";
+            cmd.n = static_cast<int>(u);
+            cmd.m = static_cast<int>(v);
+            break;
+        }
+        case OP_MST: {
+            std::string strat = lower_case(std::string(payload, size));
+            if (find(mstStrats.begin(), mstStrats.end(), strat) == mstStrats.end()){
+                cmd.error = "Invalid MST strategy\n";
+                break;
+            }
+            cmd.act = "mst";
+            cmd.strat = strat;
+            break;
+        }
+        default:
+            cmd.error = "Unknown binary opcode " + std::to_string(op) + "\n";
+    }
+    if (cmd.act == "message")
+        conn.outbox->send(cmd.error.c_str(), cmd.error.size() + 1); // Tell the client its frame was refused
+    return true;
+}
+
+// Run a decoded command
+std::pair<std::string, Graph *> handleBinary(Graph *g, const BinaryCommand &cmd, int fd_client){
+    if (cmd.act == "message")
+        return {cmd.error, nullptr}; // Invalid frame, only logged by the server
+    if (cmd.act == "newgraph")
+        return newGraph(cmd.n, cmd.m, cmd.records); // Edges come with the frame
+    return handleInput(g, cmd.act, fd_client, cmd.act, cmd.n, cmd.m, cmd.weight, cmd.strat);
+}
+
+// Create a new graph with n vertices from m packed edge records
+std::pair<std::string, Graph *> newGraph(int n, int m, const char *records){
+    std::cout << "Creating new graph with " << n << " vertices and " << m << " edges" << std::endl;
+    Graph *g = new Graph(static_cast<size_t>(n)); // Create a new graph of n vertices
+    size_t numVertices = static_cast<size_t>(n);
+    for (int i = 0; i < m; i++, records += BINARY_RECORD_SIZE){
+        size_t u = readLE32(records), v = readLE32(records + 4), weight = readLE32(records + 8);
+        if (u == 0 || v == 0 || u > numVertices || v > numVertices)
+            continue; // Skip records pointing outside the graph
+        g->addEdge(Edge(u - 1, v - 1, weight)); // Add edge from u to v
+    }
+    std::string msg = "Client successfully created a new Graph with " + std::to_string(n) + " vertices and " + std::to_string(m) + " edges" + "\n";
+    std::cout << "Graph created successfully\n";
+    return {msg, g};
+}
@@ -0,0 +1,66 @@
+#ifndef BINARY_PROTOCOL_HPP
+#define BINARY_PROTOCOL_HPP
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <utility>
+#include "../Graph/graph.hpp"
+#include "clientConn.hpp"
+
+/*
+ * Optional binary framing for graph commands, negotiated per connection.
+ *
+ * A text client switches its connection to binary by sending the line "binary". From then on every
+ * request is one frame (all integers are unsigned 32-bit little-endian):
+ *
+ *     | length | opcode (1 byte) | payload |      length counts the opcode and the payload
+ *
+ *     OP_NEWGRAPH    n, m, then m packed records (u, v, w), 12 bytes each, vertices are 1-based, n <= 2m + 1
+ *     OP_NEWEDGE     u, v, w
+ *     OP_REMOVEEDGE  u, v
+ *     OP_MST         strategy name as raw bytes, e.g. "prim"
+ *
+ * Responses stay the same text messages the text protocol gets, a refused frame gets its error. Edge records are read in place from the
+ * connection buffer, no token or string is allocated for them.
+ */
+
+enum BinaryOp : uint8_t {
+    OP_NEWGRAPH = 1,
+    OP_NEWEDGE = 2,
+    OP_REMOVEEDGE = 3,
+    OP_MST = 4
+};
+
+const size_t BINARY_HEADER_SIZE = 4;              // Length prefix
+const size_t BINARY_RECORD_SIZE = 12;             // Packed (u, v, w) edge record
+const uint32_t BINARY_MAX_FRAME = 256u << 20;     // Reject frames above 256 MiB
+
+// A decoded frame, in the same shape parseInput produces for text commands
+struct BinaryCommand {
+    std::string act;         // "newgraph", "newedge", "removeedge", "mst" or "message" when invalid
+    int n = -1, m = -1, weight = -1;
+    std::string strat;       // MST strategy
+    const char *records = nullptr; // OP_NEWGRAPH edge records, valid until the next call on the connection
+    std::string error;       // Reason when act is "message"
+};
+
+// Read a little-endian 32-bit value from an unaligned buffer
+uint32_t readLE32(const char *p);
+
+// If line is the negotiation command, switch conn to binary framing, reply to the client and return true.
+// The bytes buffered after the line are read as frames.
+bool negotiateBinary(ClientConn &conn, const std::string &line);
+
+// Decode the next complete frame buffered on conn. Returns false when no complete frame is available yet.
+// An invalid frame comes back as act "message" and its error is already queued for the client.
+bool nextBinaryCommand(ClientConn &conn, BinaryCommand &cmd, const std::vector<std::string> &mstStrats);
+
+// Run a decoded command, with the same result shape as handleInput
+std::pair<std::string, Graph *> handleBinary(Graph *g, const BinaryCommand &cmd, int fd_client);
+
+// Create a new graph with n vertices from m packed edge records, to replace the client's graph
+std::pair<std::string, Graph *> newGraph(int n, int m, const char *records);
+
+#endif // BINARY_PROTOCOL_HPP
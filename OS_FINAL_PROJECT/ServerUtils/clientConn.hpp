@@ -0,0 +1,47 @@
+#ifndef CLIENT_CONN_HPP
+#define CLIENT_CONN_HPP
+
+#include <string>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include "../Graph/graph.hpp"
+#include "resultCache.hpp"
+#include "outbox.hpp"
+
+/**
+ * @brief Per-connection protocol state, fed by the poll loop.
+ * Every recv appends to inbuf and only complete commands are consumed, so bytes that arrive
+ * together with a command (or split across several recv calls) are never lost.
+ */
+struct ClientConn {
+    uint64_t id = 0;       // Set when the connection is accepted and never reused, unlike its fd
+    bool binary = false;   // The connection negotiated the binary framing
+    bool loading = false;  // A loadgraph is running on the pool, the commands after it wait in inbuf for its graph
+    std::string inbuf;     // Bytes received but not parsed yet
+    size_t consumed = 0;   // Prefix of inbuf already handled, dropped lazily
+
+    // Text graph upload: "newgraph n m" followed by m edges "u v w", read incrementally as they arrive
+    Graph *upload = nullptr;          // Graph being filled, installed for the client once every edge arrived
+    int uploadVertices = 0;           // n of the pending newgraph
+    int uploadEdges = 0;              // m of the pending newgraph
+    int uploadRemaining = 0;          // Edges still expected
+    size_t edgeTokens[3] = {0, 0, 0}; // Numbers of the edge being read
+    int tokenCount = 0;               // How many of them were read
+
+    // MST responses of this client's graph, shared with the workers that render them
+    std::shared_ptr<ResultCache> results = std::make_shared<ResultCache>();
+    // Responses waiting to be sent, set when the connection is accepted and shared with the workers rendering them
+    std::shared_ptr<Outbox> outbox;
+
+    ClientConn() = default;
+    ClientConn(const ClientConn &) = delete;
+    ClientConn &operator=(const ClientConn &) = delete;
+    ~ClientConn() {
+        delete upload; // Drop an unfinished upload with the connection
+        if (outbox != nullptr)
+            outbox->close(); // And the responses still rendered for it
+    }
+};
+
+#endif // CLIENT_CONN_HPP
@@ -0,0 +1,43 @@
+#include "completionQueue.hpp"
+#include <sys/eventfd.h>
+#include <unistd.h>
+#include <stdint.h>
+#include <stdio.h>
+
+// Create the eventfd, non-blocking so run() never waits on it
+CompletionQueue::CompletionQueue() : eventFd(eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)), mtx(), pending() {}
+
+CompletionQueue::~CompletionQueue(){
+    if (eventFd != -1)
+        close(eventFd);
+}
+
+// Get the descriptor to poll for POLLIN
+int CompletionQueue::fd() const{
+    return eventFd;
+}
+
+// Queue done to run on the poll loop and wake the loop
+void CompletionQueue::post(std::function<void()> done){
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        pending.push_back(std::move(done));
+    }
+    uint64_t one = 1;
+    if (write(eventFd, &one, sizeof one) < 0)
+        perror("eventfd write"); // Only fails when the counter would overflow, the loop is woken already then
+}
+
+// Run the callbacks posted so far
+void CompletionQueue::run(){
+    uint64_t count = 0;
+    if (read(eventFd, &count, sizeof count) < 0)
+        return; // Woken for callbacks an earlier run already took
+    std::vector<std::function<void()>> ready;
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        ready.swap(pending);
+    }
+    for (auto &done : ready)
+        done(); // Outside the lock, a callback may post again
+}
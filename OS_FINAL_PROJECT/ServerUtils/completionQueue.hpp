@@ -0,0 +1,39 @@
+#ifndef COMPLETION_QUEUE_HPP
+#define COMPLETION_QUEUE_HPP
+
+#include <functional>
+#include <mutex>
+#include <vector>
+
+/*
+ * Work finished on other threads, handed back to the poll loop.
+ *
+ * A job that ran off the poll thread posts what is left to do with the server state (the client graphs, the poll
+ * set) as a callback. Posting writes to an eventfd the poll loop watches next to the sockets, the loop then runs
+ * every queued callback on its own thread, so the server state needs no locks.
+ */
+class CompletionQueue {
+public:
+    // Create the eventfd, fd() is -1 when that failed
+    CompletionQueue();
+    ~CompletionQueue();
+
+    CompletionQueue(const CompletionQueue &) = delete;
+    CompletionQueue &operator=(const CompletionQueue &) = delete;
+
+    // Get the descriptor to poll for POLLIN
+    int fd() const;
+
+    // Queue done to run on the poll loop and wake the loop, from any thread
+    void post(std::function<void()> done);
+
+    // Run the callbacks posted so far, on the poll loop once fd() is readable
+    void run();
+
+private:
+    int eventFd;
+    std::mutex mtx;
+    std::vector<std::function<void()>> pending;
+};
+
+#endif // COMPLETION_QUEUE_HPP
@@ -0,0 +1,116 @@
+#include "outbox.hpp"
+#include <sys/socket.h>
+#include <errno.h>
+#include <stdio.h>
+
+Outbox::Outbox(CompletionQueue &loop) : loop(loop), mtx(), parts() {}
+
+// Reserve the slot of the next response
+Outbox::Slot Outbox::reserve(){
+    std::lock_guard<std::mutex> lock(mtx);
+    parts.emplace_back();
+    return first + parts.size() - 1;
+}
+
+// Append data to slot, waking the poll loop when it is the slot being sent
+bool Outbox::write(Slot slot, const char *data, size_t len){
+    bool wake = false;
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        if (closed)
+            return false;
+        if (buffered + len > OUTBOX_LIMIT){
+            // The client stopped reading, don't keep rendering for it. The poll loop disconnects it
+            parts.clear();
+            buffered = 0;
+            closed = overflowed = true;
+            wake = true;
+        } else {
+            parts[slot - first].data.append(data, len); // The slot stays until it is closed, slot >= first
+            buffered += len;
+            wake = slot == first && !woken;
+        }
+        woken = woken || wake;
+    }
+    if (wake)
+        loop.post([](){}); // Nothing to run, the poll loop watches the socket again before it polls
+    return !overflowed;
+}
+
+// Close slot, the poll loop can move past it once it is sent
+void Outbox::done(Slot slot){
+    bool wake = false;
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        if (closed)
+            return;
+        parts[slot - first].done = true;
+        wake = slot == first && !woken;
+        woken = woken || wake;
+    }
+    if (wake)
+        loop.post([](){});
+}
+
+// Reserve, fill and close a slot at once
+bool Outbox::send(const char *data, size_t len){
+    Slot slot = reserve();
+    bool ok = write(slot, data, len);
+    done(slot);
+    return ok;
+}
+
+// Drop the finished slots at the front, true when the next one has bytes to send
+bool Outbox::ready(){
+    while (!parts.empty() && parts.front().done && parts.front().sent == parts.front().data.size()){
+        parts.pop_front();
+        first++;
+    }
+    return !parts.empty() && parts.front().sent < parts.front().data.size();
+}
+
+// Check whether there is something to send
+bool Outbox::wantsWrite(){
+    std::lock_guard<std::mutex> lock(mtx);
+    woken = overflowed || ready(); // Until then a writer wakes the loop for the first slot
+    return woken;
+}
+
+// Send the first slots while the socket takes them
+bool Outbox::flush(int fd){
+    std::lock_guard<std::mutex> lock(mtx);
+    if (overflowed){
+        fprintf(stderr, "Client on socket %d left more than %zu bytes unread, disconnecting it\n", fd, OUTBOX_LIMIT);
+        return false;
+    }
+    while (ready()){
+        Part &part = parts.front();
+        ssize_t sent = ::send(fd, part.data.data() + part.sent, part.data.size() - part.sent, MSG_DONTWAIT | MSG_NOSIGNAL);
+        if (sent < 0){
+            if (errno == EINTR)
+                continue; // Interrupted, try again
+            if (errno == EAGAIN || errno == EWOULDBLOCK)
+                return true; // The socket is full, the rest goes on the next POLLOUT
+            perror("send");
+            parts.clear();
+            buffered = 0;
+            closed = true;
+            return false;
+        }
+        part.sent += static_cast<size_t>(sent);
+        buffered -= static_cast<size_t>(sent);
+        if (part.sent == part.data.size() && !part.done){
+            part.data.clear(); // Sent so far, the writer appends the rest of the response
+            part.sent = 0;
+        }
+    }
+    return true;
+}
+
+// Drop everything, the connection is closed
+void Outbox::close(){
+    std::lock_guard<std::mutex> lock(mtx);
+    parts.clear();
+    buffered = 0;
+    closed = true;
+}
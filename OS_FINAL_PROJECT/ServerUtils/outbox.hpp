@@ -0,0 +1,77 @@
+#ifndef OUTBOX_HPP
+#define OUTBOX_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include "completionQueue.hpp"
+
+const size_t OUTBOX_LIMIT = 256u << 20; // Bytes a client may leave unread before it is disconnected
+
+/*
+ * Responses waiting to be sent to one client.
+ *
+ * Only the poll loop writes to the client's socket. Every response gets a slot when its request is read, and the
+ * slots are sent in that order, so a response rendered on a worker never splices into another one and a later
+ * request finished first waits for the earlier ones. The thread rendering a response appends to its slot as it goes
+ * and closes the slot once the response is complete. The poll loop sends the first slot, without blocking, whenever
+ * the socket has room, and moves on to the next slot once the first is closed and sent. No worker waits for the
+ * client to read.
+ *
+ * The outbox is closed with the connection, whatever is written to it afterwards is dropped.
+ */
+class Outbox {
+public:
+    typedef uint64_t Slot;
+
+    // loop is posted to, from the writing thread, when there is something new for the poll loop to send
+    explicit Outbox(CompletionQueue &loop);
+
+    Outbox(const Outbox &) = delete;
+    Outbox &operator=(const Outbox &) = delete;
+
+    // Reserve the slot of the next response, on the poll loop when its request is read
+    Slot reserve();
+
+    // Append len bytes of data to slot, from any thread. False once the outbox is closed, the writer can stop then
+    bool write(Slot slot, const char *data, size_t len);
+
+    // Close slot, its response is complete. From any thread
+    void done(Slot slot);
+
+    // Reserve a slot, write len bytes of data to it and close it, for a reply that is ready right away
+    bool send(const char *data, size_t len);
+
+    // Check whether the poll loop should watch the socket for POLLOUT, before every poll
+    bool wantsWrite();
+
+    // Send what the socket takes without blocking, on POLLOUT. False when the client can't be written to anymore,
+    // the send failed or it left more than OUTBOX_LIMIT bytes unread, and should be disconnected
+    bool flush(int fd);
+
+    // Drop everything and ignore later writes, when the connection closes
+    void close();
+
+private:
+    struct Part {
+        std::string data;  // Bytes of the response not sent yet, from offset sent
+        size_t sent = 0;
+        bool done = false; // The response is complete
+    };
+
+    CompletionQueue &loop;
+    std::mutex mtx;
+    std::deque<Part> parts;  // Reserved slots from the one being sent on
+    Slot first = 0;          // Slot of parts.front()
+    size_t buffered = 0;     // Bytes not sent yet
+    bool closed = false;
+    bool overflowed = false; // Closed because the client stopped reading
+    bool woken = false;      // The poll loop already knows the first slot has something to send
+
+    // Drop the slots that were sent and closed, true when the first slot left has bytes to send. Under mtx
+    bool ready();
+};
+
+#endif // OUTBOX_HPP
@@ -0,0 +1,146 @@
+#include "resultCache.hpp"
+#include <tuple>
+#include <utility>
+
+bool ResultKey::operator<(const ResultKey &other) const{
+    return std::tie(id, vertices, edges) < std::tie(other.id, other.vertices, other.edges);
+}
+
+// Key of the current version of g
+ResultKey versionKey(const Graph &g){
+    return ResultKey{g.version(), g.numVertices(), g.numEdges()};
+}
+
+// Key of the contents of g
+ResultKey contentKey(const Graph &g){
+    return ResultKey{g.contentHash(), g.numVertices(), g.numEdges()};
+}
+
+ResultCache::ResultCache(size_t budget) : budget(budget), used(0), lru(), index(), mtx() {}
+
+// Get the result for key
+std::shared_ptr<const CachedMST> ResultCache::get(const ResultKey &key){
+    std::lock_guard<std::mutex> lock(mtx);
+    auto found = index.find(key);
+    if (found == index.end())
+        return nullptr;
+    lru.splice(lru.begin(), lru, found->second); // Most recently used, the iterator stays valid
+    return found->second->result;
+}
+
+// Store a complete result for key
+void ResultCache::put(const ResultKey &key, const std::shared_ptr<const CachedMST> &result){
+    if (!result->complete)
+        return; // Only whole responses can be replayed
+    size_t bytes = footprint(*result);
+    std::lock_guard<std::mutex> lock(mtx);
+    if (bytes > budget)
+        return; // Would evict everything and still not fit
+    auto found = index.find(key);
+    if (found != index.end())
+        erase(found->second); // Replace the older result
+    while (used + bytes > budget)
+        erase(std::prev(lru.end())); // Least recently used first
+    lru.push_front(Slot{key, result, bytes});
+    index[key] = lru.begin();
+    used += bytes;
+}
+
+// Get the bytes currently held
+size_t ResultCache::bytes() const{
+    std::lock_guard<std::mutex> lock(mtx);
+    return used;
+}
+
+// Get the number of bytes an entry is charged
+size_t ResultCache::footprint(const CachedMST &result){
+    size_t bytes = sizeof(CachedMST) + result.text.capacity();
+    if (result.source)
+        bytes += sizeof(CSRGraph) + result.source->bytes();
+    if (result.mst)
+        bytes += sizeof(Graph) + result.mst->numVertices() * CACHED_VERTEX_BYTES + result.mst->numEdges() * CACHED_EDGE_BYTES;
+    return bytes;
+}
+
+void ResultCache::erase(std::list<Slot>::iterator it){
+    used -= it->bytes;
+    index.erase(it->key);
+    lru.erase(it);
+}
+
+ResultFlight::ResultFlight(std::shared_ptr<const CSRGraph> source) : graph(std::move(source)), mtx(), result(), callbacks() {}
+
+// Get the snapshot of the graph the result is rendered for
+const std::shared_ptr<const CSRGraph> &ResultFlight::source() const{
+    return graph;
+}
+
+// Run callback with the result once it is finished
+void ResultFlight::onDone(std::function<void(const std::shared_ptr<const CachedMST> &)> callback){
+    std::unique_lock<std::mutex> lock(mtx);
+    if (!done){
+        callbacks.push_back(std::move(callback));
+        return;
+    }
+    lock.unlock();
+    callback(result); // Already finished, result no longer changes
+}
+
+// Hand the result to everyone waiting
+void ResultFlight::finish(const std::shared_ptr<const CachedMST> &finalResult){
+    std::vector<std::function<void(const std::shared_ptr<const CachedMST> &)>> waiting;
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        result = finalResult;
+        done = true;
+        waiting.swap(callbacks);
+    }
+    for (auto &callback : waiting)
+        callback(finalResult); // Outside the lock, a callback may take its time
+}
+
+SharedResultCache::SharedResultCache(size_t budget) : store(budget), inFlight(), mtx() {}
+
+// Look up the contents of g under key, and claim them for the caller when they are neither cached nor being rendered
+ResultClaim SharedResultCache::claim(const ResultKey &key, const Graph &g){
+    ResultClaim claim;
+    std::shared_ptr<const CachedMST> cached;
+    std::shared_ptr<ResultFlight> flight;
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        cached = store.get(key);
+        auto found = inFlight.find(key);
+        if (cached == nullptr && found != inFlight.end())
+            flight = found->second;
+    }
+    // Compared outside the lock, the workers finishing other results don't wait for it
+    if (cached != nullptr && cached->source != nullptr && cached->source->matches(g)){
+        claim.result = cached;
+        return claim;
+    }
+    if (flight != nullptr && flight->source()->matches(g)){
+        claim.flight = flight; // Someone else renders it
+        return claim;
+    }
+    claim.flight = std::make_shared<ResultFlight>(std::make_shared<const CSRGraph>(g));
+    claim.owner = true;
+    if (cached == nullptr && flight == nullptr){
+        std::lock_guard<std::mutex> lock(mtx);
+        inFlight[key] = claim.flight; // Only the poll loop claims, the key is still free
+    }
+    // A different graph with the same key keeps its entry, this result is only shared once it replaces it
+    return claim;
+}
+
+// Store the result rendered by the owner of key and hand it to the waiting requests
+void SharedResultCache::finish(const ResultKey &key, const std::shared_ptr<ResultFlight> &flight,
+                               const std::shared_ptr<const CachedMST> &result){
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        store.put(key, result); // Ignored when incomplete
+        auto found = inFlight.find(key);
+        if (found != inFlight.end() && found->second == flight)
+            inFlight.erase(found); // Not a flight for another graph with the same key
+    }
+    flight->finish(result); // Requests that claim key from now on find it in the store, or render it again
+}
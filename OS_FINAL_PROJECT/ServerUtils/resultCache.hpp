@@ -0,0 +1,140 @@
+#ifndef RESULT_CACHE_HPP
+#define RESULT_CACHE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "../Graph/graph.hpp"
+
+/*
+ * Caches of MST responses.
+ *
+ * Every client has a ResultCache keyed by the graph version. Graph versions change on every edit and are never
+ * reused, so an entry can't go stale, it only stops being asked for. The key doesn't need the strategy either:
+ * once a tree was computed the graph tracks it (see DynamicMST), and every strategy asked about the same version
+ * gets that same tree.
+ *
+ * The server has one SharedResultCache keyed by the graph contents, so clients that uploaded the same graph share
+ * one computation. A request for contents that another request is still rendering waits for that result instead of
+ * starting its own. The content key is only a hash: every shared result keeps a CSR snapshot of the graph it was
+ * computed for, and a request only gets it when its graph matches that snapshot edge for edge.
+ *
+ * Entries are bounded by a byte budget and the least recently used is evicted first. Entries are shared pointers,
+ * a response being streamed stays alive while the cache evicts it.
+ */
+
+const size_t RESULT_CACHE_BUDGET = 64u << 20;         // Bytes of cached results per client
+const size_t SHARED_RESULT_CACHE_BUDGET = 256u << 20; // Bytes of cached results shared by all the clients
+const size_t CACHED_VERTEX_BYTES = 128;       // Approximate heap footprint of a vertex of a cached MST
+const size_t CACHED_EDGE_BYTES = 160;         // Approximate heap footprint of an edge of a cached MST
+
+// Cached MST of one graph version
+struct CachedMST {
+    std::shared_ptr<Graph> mst;
+    std::shared_ptr<const CSRGraph> source; // The graph the MST was computed for, set when it is shared by content
+    std::string text;      // The rendered statistics, as streamed to the client
+    bool complete = true;  // Cleared when the text did not fit in the budget or could not be sent whole
+};
+
+// Key of a cached result: a graph version or content hash, with the sizes of the graph as a check against collisions
+struct ResultKey {
+    uint64_t id;
+    size_t vertices;
+    size_t edges;
+
+    bool operator<(const ResultKey &other) const;
+};
+
+// Key of the current version of g, for the client's own cache
+ResultKey versionKey(const Graph &g);
+// Key of the contents of g, for the cache shared by all the clients
+ResultKey contentKey(const Graph &g);
+
+class ResultCache {
+public:
+    explicit ResultCache(size_t budget = RESULT_CACHE_BUDGET);
+
+    // Get the result for key, null when it is not cached. Marks it as the most recently used.
+    std::shared_ptr<const CachedMST> get(const ResultKey &key);
+
+    // Store a complete result for key, evicting the least recently used entries over the budget
+    void put(const ResultKey &key, const std::shared_ptr<const CachedMST> &result);
+
+    // Get the bytes currently held
+    size_t bytes() const;
+
+    // Get the number of bytes an entry is charged
+    static size_t footprint(const CachedMST &result);
+
+private:
+    struct Slot {
+        ResultKey key;
+        std::shared_ptr<const CachedMST> result;
+        size_t bytes;
+    };
+
+    size_t budget;
+    size_t used;
+    std::list<Slot> lru;                                  // Most recently used first
+    std::map<ResultKey, std::list<Slot>::iterator> index;
+    mutable std::mutex mtx;                               // Results are stored from the worker threads
+
+    void erase(std::list<Slot>::iterator it);
+};
+
+// A result being rendered by one request that other requests for the same key wait for
+class ResultFlight {
+public:
+    // source is a snapshot of the graph the result is rendered for
+    explicit ResultFlight(std::shared_ptr<const CSRGraph> source);
+
+    // Get the snapshot of the graph the result is rendered for, the owner computes the MST on it
+    const std::shared_ptr<const CSRGraph> &source() const;
+
+    // Run callback with the result once it is finished, right away if it already is. Runs on the finishing thread.
+    void onDone(std::function<void(const std::shared_ptr<const CachedMST> &)> callback);
+
+    // Hand the result to everyone waiting. It may be incomplete, its MST is still usable.
+    void finish(const std::shared_ptr<const CachedMST> &result);
+
+private:
+    const std::shared_ptr<const CSRGraph> graph;
+    std::mutex mtx;
+    bool done = false;
+    std::shared_ptr<const CachedMST> result;
+    std::vector<std::function<void(const std::shared_ptr<const CachedMST> &)>> callbacks;
+};
+
+// Outcome of SharedResultCache::claim, exactly one of the three cases
+struct ResultClaim {
+    std::shared_ptr<const CachedMST> result; // Cached: send it
+    std::shared_ptr<ResultFlight> flight;    // Being rendered by another request: wait for it, or render it when owner
+    bool owner = false;                      // Nobody has it: the caller renders it for flight->source() and calls finish
+};
+
+class SharedResultCache {
+public:
+    explicit SharedResultCache(size_t budget = SHARED_RESULT_CACHE_BUDGET);
+
+    // Look up the contents of g under key, and claim them for the caller when they are neither cached nor being
+    // rendered. A result or flight whose graph only shares the key with g is not used, the caller renders its own.
+    // Runs on the poll loop, O(V + E) for the comparison or the owner's snapshot
+    ResultClaim claim(const ResultKey &key, const Graph &g);
+
+    // Store the result rendered by the owner of key if it is complete and hand it to the waiting requests
+    void finish(const ResultKey &key, const std::shared_ptr<ResultFlight> &flight,
+                const std::shared_ptr<const CachedMST> &result);
+
+private:
+    ResultCache store;
+    std::map<ResultKey, std::shared_ptr<ResultFlight>> inFlight;
+    std::mutex mtx; // Taken before the store's own lock
+};
+
+#endif // RESULT_CACHE_HPP
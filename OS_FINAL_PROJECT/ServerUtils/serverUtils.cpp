@@ -1,4 +1,7 @@
 #include "serverUtils.hpp"
+#include "binaryProtocol.hpp"
+#include <new>
+#include <cstdlib>
 
 extern LFP lfp; // Leader-Follower pattern instance
 
@@ -11,10 +14,7 @@ std::pair<std::string, Graph *> handleInput(Graph *g, std::string act, int fd_cl
         return {msg, nullptr}; // Handle empty message
     }
 
-    if (current_act == "newgraph"){ 
-        return newGraph(n, m, fd_client, g); // Create a new graph
-    }
-    else if (current_act == "newedge"){
+    if (current_act == "newedge"){
         if (g != nullptr){
             return newEdge(static_cast<size_t>(n), static_cast<size_t>(m), static_cast<size_t>(w), fd_client, g); // Add an edge
         }
@@ -56,6 +56,21 @@ void *getInAddr(struct sockaddr *sa){
 }
 
 
+// Get the id of a newly accepted connection
+uint64_t nextConnectionId(){
+    static uint64_t last = 0; // Only the poll loop accepts
+    return ++last;
+}
+
+// Get the connection on fd if it is still the one with id
+ClientConn *liveConnection(std::map<int, ClientConn> &conns, int fd, uint64_t id){
+    auto it = conns.find(fd);
+    if (it == conns.end() || it->second.id != id)
+        return nullptr; // Closed, maybe replaced by a later connection on the same fd
+    return &it->second;
+}
+
+
 // Return a listening socket
 int getListenerSocket(void){
     int listener; // Listening socket descriptor
@@ -105,6 +120,7 @@ void add_to_pfds(struct pollfd *pfds[], int new_fd, int *count, int *size){
     }
     (*pfds)[*count].fd = new_fd; // Set new file descriptor
     (*pfds)[*count].events = POLLIN; // Check for ready-to-read
+    (*pfds)[*count].revents = 0; // The loop may reach the new entry in the pass that accepted it
     *count = (*count)+1; // Increment count of file descriptors
 }
 
@@ -114,6 +130,27 @@ void del_from_pfds(struct pollfd pfds[], int i, int *count){
     *count = (*count)-1; // Decrement the count of file descriptors
 }
 
+// Stream sink that appends every chunk to a slot of the client's outbox and keeps a copy of the stream while it fits
+std::function<bool(std::string &)> capturingSink(const std::shared_ptr<Outbox> &out, Outbox::Slot slot, std::string &copy, bool &complete, size_t limit){
+    return [out, slot, &copy, &complete, limit](std::string &chunk){
+        if (complete){
+            if (copy.size() + chunk.size() <= limit)
+                copy += chunk;
+            else{
+                complete = false;
+                std::string().swap(copy); // Too large to keep, release it now
+            }
+        }
+        bool ok = out->write(slot, chunk.data(), chunk.size());
+        chunk.clear();
+        if (!ok){
+            complete = false; // The client is gone, don't replay a broken response
+            std::string().swap(copy);
+        }
+        return ok;
+    };
+}
+
 //////////////////////////// Graph - function ///////////////////////
 
 // Initialize vertices for the graph
@@ -124,42 +161,188 @@ std::unordered_set<Vertex> initVertices(int n){
     return vertices;
 }
 
-void initGraph(Graph *g, int m, int clientFd)
-{
+// Install the uploaded graph for the client in place of its current graph, the server releases the current one
+static void finishUpload(ClientConn &conn, const TextResponder &respond){
+    Graph *g = conn.upload;
+    conn.upload = nullptr;
+    std::string msg = "Client successfully created a new Graph with " + std::to_string(conn.uploadVertices) + " vertices and " + std::to_string(conn.uploadEdges) + " edges" + "\n";
+    std::cout << "Graph created successfully\n";
+    respond("newgraph", {msg, g});
+}
+
+// Start reading a text graph upload of n vertices and m edges, the edges follow on the connection
+static void startUpload(ClientConn &conn, int n, int m, const TextResponder &respond){
+    std::cout << "Creating new graph with " << n << " vertices and " << m << " edges" << std::endl;
+    delete conn.upload; // Drop an unfinished upload
+    conn.upload = new Graph(static_cast<size_t>(n)); // The client's current graph stays until every edge arrived
+    conn.uploadVertices = n;
+    conn.uploadEdges = m;
+    conn.uploadRemaining = m;
+    conn.tokenCount = 0;
     std::string msg = "To create an edge u->v with weight w please enter the edge number in the format: u v w \n";
-    if (send(clientFd, msg.c_str(), msg.size(), 0) < 0)
-    {
-        perror("send");
+    conn.outbox->send(msg.c_str(), msg.size());
+    if (m == 0)
+        finishUpload(conn, respond); // Nothing to wait for
+}
+
+// Read the edge numbers buffered from pos, returns false when the buffer ends inside a number
+static bool readUploadEdges(ClientConn &conn, size_t &pos, const TextResponder &respond){
+    const std::string &in = conn.inbuf;
+    while (conn.upload != nullptr){
+        while (pos < in.size() && isspace(static_cast<unsigned char>(in[pos])))
+            pos++; // Skip the separators, edges may span lines and recv calls
+        size_t end = pos;
+        while (end < in.size() && !isspace(static_cast<unsigned char>(in[end])))
+            end++;
+        if (end == in.size())
+            return false; // The number may continue in the next recv
+        if (end - pos > 19 || !std::all_of(in.begin() + static_cast<std::ptrdiff_t>(pos), in.begin() + static_cast<std::ptrdiff_t>(end), ::isdigit)){
+            // Not an edge number, drop the upload and read the rest as a command
+            delete conn.upload;
+            conn.upload = nullptr;
+            respond("message", {"Invalid edge, the upload of the new graph was aborted\n", nullptr});
+            return true;
+        }
+        conn.edgeTokens[conn.tokenCount++] = strtoull(in.c_str() + pos, nullptr, 10);
+        pos = end;
+        if (conn.tokenCount < 3)
+            continue;
+        conn.tokenCount = 0;
+        size_t u = conn.edgeTokens[0], v = conn.edgeTokens[1], weight = conn.edgeTokens[2];
+        size_t numVertices = static_cast<size_t>(conn.uploadVertices);
+        if (u != 0 && v != 0 && u <= numVertices && v <= numVertices)
+            conn.upload->addEdge(Edge(u - 1, v - 1, weight)); // Add edge from u to v, skip edges outside the graph
+        if (--conn.uploadRemaining == 0)
+            finishUpload(conn, respond);
     }
-    int stdin_save = dup(STDIN_FILENO); // Save the current state of STDIN
-    dup2(clientFd, STDIN_FILENO);       // Redirect STDIN to the socket
-    for (int i = 0; i < m; i++)
-    { // Read the edges
-        size_t u, v, weight;
-        std::cin >> u >> v >> weight;
-        Edge e = Edge(g->getVertex(u - 1), g->getVertex(v - 1), weight);
-        g->addEdge(e); // Add edge from u to v
+    return true;
+}
+
+// Run every complete command buffered on a text connection
+void processText(ClientConn &conn, int fd_client, const std::vector<std::string> &commands_graph, const std::vector<std::string> &mst_starts,
+                 const std::function<Graph *(const std::string &)> &graph, const TextResponder &respond,
+                 const std::function<void(const std::string &)> &load){
+    std::string &in = conn.inbuf;
+    size_t pos = 0; // Start of the unparsed bytes
+    while (pos < in.size()){
+        if (conn.loading)
+            break; // The next commands need the graph being loaded
+        if (conn.upload != nullptr){
+            if (!readUploadEdges(conn, pos, respond))
+                break; // Wait for the rest of the edges
+            continue;
+        }
+        size_t eol = in.find('\n', pos);
+        if (eol == std::string::npos){
+            if (in.size() - pos > TEXT_MAX_LINE){
+                respond("message", {"Command line too long, dropped\n", nullptr});
+                pos = in.size();
+            }
+            break; // Wait for the end of the line
+        }
+        std::string line = in.substr(pos, eol + 1 - pos); // Keep the newline, messages are logged as sent
+        pos = eol + 1;
+        if (negotiateBinary(conn, line))
+            break; // The client switched to binary framing, the rest of the buffer is frames
+
+        std::vector<char> cmd(line.begin(), line.end());
+        cmd.push_back('\0'); // Room for the terminator parseInput writes
+        int n = 0, m = 0, weight = 0;
+        std::string strat, act, current_act;
+        parseInput(cmd.data(), static_cast<int>(line.size()), n, m, weight, strat, act, current_act, commands_graph, mst_starts);
+        std::cout << "Act received: " << act << " from client: " << fd_client << std::endl;
+        if (current_act == "newgraph")
+            startUpload(conn, n, m, respond); // The edges are read from the following bytes
+        else if (current_act == "loadgraph"){
+            conn.loading = true;
+            load(commandArgument(line)); // Read on the pool, the server replies when the graph is installed
+        }
+        else
+            respond(current_act, handleInput(graph(current_act), act, fd_client, current_act, n, m, weight, strat));
     }
-    dup2(stdin_save, STDIN_FILENO); // Restore the original STDIN
+    in.erase(0, pos); // Drop the handled bytes
 }
 
-// Create a new graph with n vertices and m edges
-std::pair<std::string, Graph *> newGraph(int n, int m, int fd_client, Graph *g){
-    std::cout << "Creating new graph with " << n << " vertices and " << m << " edges" << std::endl;
-    if (g != nullptr)
-        delete g; // Delete the existing graph if not null
-    std::unordered_set<Vertex> vertices = initVertices(n); // Initialize the vertices
-    g = new Graph(vertices);   // Create a new graph of n vertices
-    initGraph(g, m, fd_client); // Initialize the graph with m edges
-    std::string msg = "Client successfully created a new Graph with " + std::to_string(n) + " vertices and " + std::to_string(m) + " edges" + "\n";
-    std::cout << "Graph created successfully\n";
-    return {msg, g}; 
+// Resolve a client's graph file path inside the data directory
+bool dataPath(const std::string &path, std::string &resolved, std::string &error){
+    if (path.empty() || path[0] == '/'){
+        error = "the path must be relative to the data directory";
+        return false;
+    }
+    std::istringstream parts(path);
+    std::string part;
+    while (std::getline(parts, part, '/')){
+        if (part == ".."){
+            error = "the path can't leave the data directory";
+            return false;
+        }
+    }
+    const char *dir = getenv("GRAPH_DATA_DIR");
+    char *base = realpath(dir != nullptr && *dir != '\0' ? dir : ".", nullptr);
+    if (base == nullptr){
+        error = "the data directory is not available";
+        return false;
+    }
+    std::string root = base;
+    free(base);
+    char *full = realpath((root + "/" + path).c_str(), nullptr);
+    if (full == nullptr){
+        error = "there is no graph file " + path;
+        return false;
+    }
+    resolved = full;
+    free(full);
+    std::string prefix = root == "/" ? root : root + "/";
+    if (resolved.compare(0, prefix.size(), prefix) != 0){
+        error = "the path can't leave the data directory"; // A link out of it
+        return false;
+    }
+    return true;
+}
+
+// Load a graph from an edge-list file in the data directory to replace the client's graph
+std::pair<std::string, Graph *> loadGraph(const std::string &path, int fd_client){
+    std::cout << "Loading graph from " << path << std::endl;
+    std::string error, resolved;
+    Graph *loaded = nullptr;
+    if (dataPath(path, resolved, error)){
+        try {
+            loaded = Graph::load(resolved, error);
+        } catch (const std::bad_alloc &) {
+            error = "not enough memory for the graph"; // The header passed the checks, but the graph is still too big
+        }
+        // Name the file as the client did, not where it lives on the server
+        for (size_t at = error.find(resolved); at != std::string::npos; at = error.find(resolved, at + path.size()))
+            error.replace(at, resolved.size(), path);
+    }
+    if (loaded == nullptr){
+        std::cout << "Loading failed: " << error << std::endl;
+        return {"Client " + std::to_string(fd_client) + " failed to load a graph: " + error + "\n", nullptr}; // Keep the current graph
+    }
+    std::string msg = "Client successfully loaded a new Graph with " + std::to_string(loaded->numVertices()) + " vertices and " + std::to_string(loaded->numEdges()) + " edges from " + path + "\n";
+    std::cout << "Graph loaded successfully\n";
+    return {msg, loaded};
+}
+
+// Get the client's graph for a command, copied first when the command edits it while a job still reads it
+Graph *graphFor(std::shared_ptr<Graph> &graph, const std::string &act){
+    if (graph != nullptr && graph.use_count() > 1 && (act == "newedge" || act == "removeedge"))
+        graph.reset(graph->clone()); // The job keeps the graph it started from, the client edits the copy
+    return graph.get();
+}
+
+// Reply to an edge command naming a vertex the graph doesn't have, vertices are numbered from 1
+static std::string outsideGraph(int fd_client, const Graph *g){
+    std::cout << "Edge outside the graph" << std::endl;
+    return "Client " + std::to_string(fd_client) + " named a vertex outside the graph, vertices are 1 to " + std::to_string(g->numVertices()) + "\n";
 }
 
 // Add a new edge to the existing graph
 std::pair<std::string, Graph *> newEdge(size_t n, size_t m, size_t weight, int fd_client, Graph *g){
+    if (n == 0 || m == 0 || n > g->numVertices() || m > g->numVertices())
+        return {outsideGraph(fd_client, g), nullptr}; // Keep the graph as it is
     std::cout << "Adding an edge from " << n << " to " << m << std::endl;
-    g->addEdge(Edge(g->getVertex(n - 1), g->getVertex(m - 1), weight)); // Add edge from u to v
+    g->addEdge(Edge(n - 1, m - 1, weight)); // Add edge from u to v
     std::string msg = "Client " + std::to_string(fd_client) + " added an edge from " + std::to_string(n) + " to " + std::to_string(m) + " with weight " + std::to_string(weight) + "\n";
 
     return {msg, g}; // Return success message and the updated graph
@@ -167,8 +350,10 @@ std::pair<std::string, Graph *> newEdge(size_t n, size_t m, size_t weight, int f
 
 // Remove an edge from the existing graph
 std::pair<std::string, Graph *> removeedge(int n, int m, int fd_client, Graph *g){
+    if (n <= 0 || m <= 0 || static_cast<size_t>(n) > g->numVertices() || static_cast<size_t>(m) > g->numVertices())
+        return {outsideGraph(fd_client, g), nullptr};
     std::cout << "Removing an edge from " << n << " to " << m << std::endl;
-    g->removeEdge(Edge{g->getVertex(n - 1), g->getVertex(m - 1)}); // Remove edge from u to v
+    g->removeEdge(Edge{static_cast<size_t>(n - 1), static_cast<size_t>(m - 1)}); // Remove edge from u to v
     std::string msg = "Client " + std::to_string(fd_client) + " removed an edge from " + std::to_string(n) + " to " + std::to_string(m) + "\n";
 
     return {msg, g}; // Return success message and the updated graph
@@ -197,6 +382,17 @@ bool string_is_num(const std::vector<std::string> &s){
 }
 
 
+// Get everything after the first word of a command line, without the surrounding spaces
+std::string commandArgument(const std::string &line){
+    size_t start = line.find_first_not_of(" \t\r\n");
+    start = line.find_first_of(" \t", start == std::string::npos ? line.size() : start); // End of the command word
+    start = line.find_first_not_of(" \t", start == std::string::npos ? line.size() : start);
+    if (start == std::string::npos)
+        return "";
+    size_t end = line.find_last_not_of(" \t\r\n");
+    return line.substr(start, end + 1 - start);
+}
+
 // Split a string into command by spaces
 std::vector<std::string> split_spaces(const std::string &input){
     std::istringstream stream(input);
@@ -240,6 +436,11 @@ void parseInput(char *buf, int numOfBytes, int &n, int &m, int &weight, std::str
             current_act = "message"; // No strategy provided
         }
     }
+    else if (current_act == "loadgraph"){ // The path is read from the original line, it must keep its case
+        if (command.size() < 2){
+            current_act = "message"; // No path provided
+        }
+    }
     else if (!string_is_num(command)){ // Check if command are numbers
         current_act = "message"; // Not valid numbers
         cout << "Not a number" << endl;
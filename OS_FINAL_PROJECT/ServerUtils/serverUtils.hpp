@@ -77,8 +77,17 @@
 #include <poll.h>       // Include this header for pollfd
 #include "../MST/MST_Factory.hpp"
 #include <string.h>
+#include <errno.h>
+#include <functional>
+#include <map>
 #define PORT "8080" // Port we're listening on
 #include "../LF/LeaderFollower.hpp"
+#include "clientConn.hpp"
+
+const size_t TEXT_MAX_LINE = 64 * 1024; // Longest text command kept while waiting for its newline
+
+// Callback the servers use to store and broadcast the result of a command: (act, {message, graph})
+typedef std::function<void(const std::string &, const std::pair<std::string, Graph *> &)> TextResponder;
 
 // Declare the MST function as extern
 extern std::pair<std::string, Graph *> MST(Graph *g, int clientFd, const std::string &strat);
@@ -86,26 +95,56 @@ extern std::pair<std::string, Graph *> MST(Graph *g, int clientFd, const std::st
 // Function to convert a string to lowercase
 std::string lower_case(std::string s);
 
-void initGraph(Graph *g, int m, int clientFd);
-
 std::vector<std::string> split_spaces(const std::string &input);
 
+// Get everything after the first word of a command line, e.g. the path of "loadgraph <path>"
+std::string commandArgument(const std::string &line);
+
 void parseInput(char *buf, int nbytes, int &n, int &m, int &weight, std::string &strat, std::string &action, std::string &actualAction, const std::vector<std::string> &graphActions, const std::vector<std::string> &mstStrats);
 
 std::unordered_set<Vertex> initVertices(int n);
 
-std::pair<std::string, Graph *> newGraph(int n, int m, int clientFd, Graph *g);
-
 std::pair<std::string, Graph *> newEdge(size_t n, size_t m, size_t weight, int clientFd, Graph *g);
 
+// Load a graph from a text or binary edge-list file in the data directory (see dataPath) to replace the client's
+// graph. Runs on a worker, the message only names the path as the client gave it
+std::pair<std::string, Graph *> loadGraph(const std::string &path, int clientFd);
+
+// Resolve the path of a graph file a client named inside the data directory: $GRAPH_DATA_DIR, or the working
+// directory when it is not set. Absolute paths, ".." and links leading out of the directory are refused
+bool dataPath(const std::string &path, std::string &resolved, std::string &error);
+
 std::pair<std::string, Graph *> removeedge(int n, int m, int clientFd, Graph *g);
 
 std::pair<std::string, Graph *> handleInput(Graph *g, std::string action, int clientFd, std::string actualAction, int n, int m, int w, std::string strat);
 
+// Run every complete newline-terminated command buffered on a text connection. A command is only run once its '\n'
+// arrived, one still missing it when the connection closes is dropped. "newgraph n m" starts an upload whose
+// edges are read from the following bytes as they arrive, other clients are served in between. graph returns the
+// client's graph for a command (see graphFor). Stops when the client switches to binary framing, conn.inbuf then
+// holds only frame bytes. A new graph is handed to respond, the server releases the one it replaces.
+// "loadgraph <path>" sets conn.loading and hands the path to load, which reads the file off the poll loop. The
+// commands after it stay in conn.inbuf until the server installed the graph, cleared conn.loading and called
+// processText again.
+void processText(ClientConn &conn, int clientFd, const std::vector<std::string> &graphActions, const std::vector<std::string> &mstStrats,
+                 const std::function<Graph *(const std::string &)> &graph, const TextResponder &respond,
+                 const std::function<void(const std::string &)> &load);
+
+// Get the client's graph for the command act. MST jobs share the graph they run on, a command that edits the graph
+// while one still does gets a copy to edit instead (copy-on-write) and the copy becomes the client's graph.
+Graph *graphFor(std::shared_ptr<Graph> &graph, const std::string &act);
+
 
 // Get sockaddr, IPv4 or IPv6:
 void *getInAddr(struct sockaddr *sa);
 
+// Get the id of a newly accepted connection, on the poll loop
+uint64_t nextConnectionId();
+
+// Get the connection on fd if it is still the one with id, nullptr once that one closed and the fd may belong to a
+// later connection. Work finished off the poll loop checks it before it touches the client's state.
+ClientConn *liveConnection(std::map<int, ClientConn> &conns, int fd, uint64_t id);
+
 
 // Return a listening socket
 int getListenerSocket();
@@ -118,4 +157,9 @@ void add_to_pfds(struct pollfd *pfds[], int newfd, int *fd_count, int *fd_size);
 // Remove an index from the set
 void del_from_pfds(struct pollfd pfds[], int i, int *fd_count);
 
+// Stream sink for Graph::streamStats / streamShortestPaths that appends every chunk to the slot of out, it never
+// waits for the client. Also appends every chunk to copy while copy stays within limit bytes, complete is cleared
+// and copy dropped once a chunk no longer fits or the outbox is closed. Fails once the outbox is closed.
+std::function<bool(std::string &)> capturingSink(const std::shared_ptr<Outbox> &out, Outbox::Slot slot, std::string &copy, bool &complete, size_t limit);
+
 #endif // SERVER_UTILS_HPP
\ No newline at end of file